@@ -0,0 +1,432 @@
+#ifndef CUID_BENCH_H
+/*
+** The cuid benchmarks.
+**
+** Build and run them with `make bench`. Each benchmark generates a number of
+** cuids (or base36 blocks, or random numbers) and reports one line with:
+**
+**   name,threads,batch,count,ns_per_op,ops_per_sec,cycles_per_op
+**
+** as CSV (the default) or as JSON lines with the `--json` argument. The
+** number of operations per benchmark can be set with `-n <count>`.
+**
+** `ns_per_op` is the wall time per operation of each thread, `ops_per_sec`
+** is the total throughput of all threads and `cycles_per_op` is measured
+** with the time stamp counter where available (x86_64), 0 otherwise.
+**
+** The SIMD kernels are those of the best CPU level, set the CUID_CPU_LEVEL
+** environment variable to compare them with another level, e.g.
+** `CUID_CPU_LEVEL=scalar ./.cbuild/bench`.
+*/
+#include <pthread.h> // pthread_create, pthread_join
+#include <string.h> // strcmp, memcpy
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <x86intrin.h> // __rdtsc
+#endif
+
+/*
+** Returns a monotonic time in nanoseconds.
+*/
+static inline uint64_t
+cuid_bench_ns(void) {
+  struct timespec now = {0};
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+/*
+** Returns the time stamp counter, or 0 when it is not available.
+*/
+static inline uint64_t
+cuid_bench_cycles(void) {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+// Each benchmark writes its results here so they are not optimized away
+static volatile uint32_t cuid_bench_sink = 0;
+
+// Sums the last chars of the counter and of the cuid into the sink
+static inline void
+cuid_bench_consume(char const *result) {
+  cuid_bench_sink += (uint32_t)result[CUID_SIZE - 2]
+                   + (uint32_t)result[CUID_FINGERPRINT_OFFSET - 1];
+}
+
+/*
+** A benchmark receives the number of operations to do and the batch size
+** for the batch functions.
+*/
+typedef void (*cuid_bench_fn)(size_t count, size_t batch);
+
+static char cuid_bench_fingerprint[CUID_FINGERPRINT_SIZE] = "bnch";
+
+static void
+cuid_bench_cuid(size_t count, size_t batch) {
+  char result[CUID_SIZE] = {0};
+  for (size_t i = 0; i < count; ++i) {
+    cuid(result);
+    cuid_bench_consume(result);
+  }
+}
+
+static void
+cuid_bench_cuid_n(size_t count, size_t batch) {
+  char (*results)[CUID_SIZE] = malloc(batch * CUID_SIZE);
+  for (size_t i = 0; i < count; i += batch) {
+    size_t const n = count - i < batch ? count - i : batch;
+    cuid_n(results, n);
+    cuid_bench_consume(results[n - 1]);
+  }
+  free(results);
+}
+
+static void
+cuid_bench_pure_value(size_t count, size_t batch) {
+  cuid_t *id = malloc(sizeof(cuid_t));
+  *id = cuid_init(cuid_create(cuid_bench_fingerprint), CUID_GET_TIMESTAMP());
+  char result[CUID_SIZE] = {0};
+  for (size_t i = 0; i < count; ++i) {
+    *id = cuid_next(*id, CUID_GET_TIMESTAMP());
+    cuid_read(*id, result);
+    cuid_bench_consume(result);
+  }
+  free(id);
+}
+
+static void
+cuid_bench_pure_inplace(size_t count, size_t batch) {
+  cuid_t *id = malloc(sizeof(cuid_t));
+  cuid_create_inplace(id, cuid_bench_fingerprint);
+  cuid_init_inplace(id, CUID_GET_TIMESTAMP());
+  char result[CUID_SIZE] = {0};
+  for (size_t i = 0; i < count; ++i) {
+    cuid_next_inplace(id, CUID_GET_TIMESTAMP());
+    cuid_read_ptr(id, result);
+    cuid_bench_consume(result);
+  }
+  free(id);
+}
+
+static void
+cuid_bench_generate_n(size_t count, size_t batch) {
+  cuid_t *id = malloc(sizeof(cuid_t));
+  cuid_create_inplace(id, cuid_bench_fingerprint);
+  cuid_init_inplace(id, CUID_GET_TIMESTAMP());
+  char (*results)[CUID_SIZE] = malloc(batch * CUID_SIZE);
+  for (size_t i = 0; i < count; i += batch) {
+    size_t const n = count - i < batch ? count - i : batch;
+    cuid_generate_n(id, CUID_GET_TIMESTAMP(), n, results);
+    cuid_bench_consume(results[n - 1]);
+  }
+  free(results);
+  free(id);
+}
+
+#ifdef CUID_ARENA
+/*
+** The `batch` is the number of generators of the arena here, each cuid is
+** made by a generator picked in a scattered order.
+*/
+static void
+cuid_bench_arena_next(size_t count, size_t batch) {
+  cuid_arena_t arena;
+  cuid_arena_map(&arena, batch, cuid_bench_fingerprint);
+  char result[CUID_SIZE] = {0};
+  for (size_t i = 0; i < count; ++i) {
+    size_t const index = (size_t)((i * 2654435761U) % batch);
+    cuid_arena_next(&arena, index, CUID_GET_TIMESTAMP(), result);
+    cuid_bench_consume(result);
+  }
+  cuid_arena_destroy(&arena);
+}
+#endif /* CUID_ARENA */
+
+#ifdef CUID_SHM
+/*
+** Each thread opens its own handle on the same segment.
+*/
+static void
+cuid_bench_shm_next(size_t count, size_t batch) {
+  char name[64] = {0};
+  snprintf(name, sizeof name, "/cuid_bench_%ld", (long)getpid());
+  cuid_shm_t shm;
+  if (!cuid_shm_open(&shm, name, cuid_bench_fingerprint)) {
+    return;
+  }
+  char result[CUID_SIZE] = {0};
+  for (size_t i = 0; i < count; ++i) {
+    cuid_shm_next(&shm, CUID_GET_TIMESTAMP(), result);
+    cuid_bench_consume(result);
+  }
+  cuid_shm_close(&shm);
+  cuid_shm_unlink(name);
+}
+#endif /* CUID_SHM */
+
+static void
+cuid_bench_base36(size_t count, size_t batch) {
+  char result[CUID_BASE36_RESULT_SIZE] = {0};
+  for (size_t i = 0; i < count; ++i) {
+    cuid_base36((uint64_t)i * 2654435761U, result);
+    cuid_bench_sink += (uint32_t)result[0];
+  }
+}
+
+static void
+cuid_bench_base36_pad(size_t count, size_t batch) {
+  char result[CUID_BASE36_RESULT_SIZE] = {0};
+  for (size_t i = 0; i < count; ++i) {
+    cuid_base36_pad((uint64_t)i * 2654435761U, result, 4, '0');
+    cuid_bench_sink += (uint32_t)result[0];
+  }
+}
+
+static void
+cuid_bench_base36_block(size_t count, size_t batch) {
+  char result[4] = {0};
+  for (size_t i = 0; i < count; ++i) {
+    cuid_base36_block((uint32_t)i * 2654435761U, result);
+    cuid_bench_sink += (uint32_t)result[0];
+  }
+}
+
+static void
+cuid_bench_base36_blocks(size_t count, size_t batch) {
+  uint32_t *values = malloc(batch * sizeof(uint32_t));
+  char *results = malloc(batch * 4);
+  for (size_t i = 0; i < batch; ++i) {
+    values[i] = (uint32_t)i * 2654435761U;
+  }
+  for (size_t i = 0; i < count; i += batch) {
+    size_t const n = count - i < batch ? count - i : batch;
+    cuid_base36_blocks(values, n, results, 4);
+    cuid_bench_sink += (uint32_t)results[0];
+  }
+  free(results);
+  free(values);
+}
+
+static void
+cuid_bench_hash(size_t count, size_t batch) {
+  char result[CUID_SIZE] = {0};
+  cuid(result);
+  for (size_t i = 0; i < count; ++i) {
+    result[CUID_SIZE - 2] = cuid_base36_digits[i % 36];
+    cuid_bench_sink += (uint32_t)cuid_hash(result);
+  }
+}
+
+static void
+cuid_bench_compare(size_t count, size_t batch) {
+  char a[CUID_SIZE] = {0};
+  char b[CUID_SIZE] = {0};
+  cuid(a);
+  memcpy(b, a, CUID_SIZE);
+  for (size_t i = 0; i < count; ++i) {
+    b[CUID_SIZE - 2] = cuid_base36_digits[i % 36];
+    cuid_bench_sink += (uint32_t)cuid_compare(a, b);
+  }
+}
+
+static void
+cuid_bench_mwc_next_random(size_t count, size_t batch) {
+  mwc_random_t *r = malloc(sizeof(mwc_random_t));
+  mwc_create_ptr(r);
+  for (size_t i = 0; i < count; ++i) {
+    *r = mwc_next_random(*r);
+    cuid_bench_sink += mwc_read_random(*r);
+  }
+  free(r);
+}
+
+static void
+cuid_bench_mwc_next_random_ptr(size_t count, size_t batch) {
+  mwc_random_t *r = malloc(sizeof(mwc_random_t));
+  mwc_create_ptr(r);
+  for (size_t i = 0; i < count; ++i) {
+    mwc_next_random_ptr(r);
+    cuid_bench_sink += mwc_read_random_ptr(r);
+  }
+  free(r);
+}
+
+static void
+cuid_bench_mwc_fill(size_t count, size_t batch) {
+  mwc_random_t *r = malloc(sizeof(mwc_random_t));
+  uint32_t *numbers = malloc(batch * sizeof(uint32_t));
+  mwc_create_ptr(r);
+  for (size_t done = 0; done < count; done += batch) {
+    size_t const n = count - done < batch ? count - done : batch;
+    mwc_fill_ptr(r, numbers, n);
+    cuid_bench_sink += numbers[n - 1];
+  }
+  free(numbers);
+  free(r);
+}
+
+static void
+cuid_bench_pcg32_fill(size_t count, size_t batch) {
+  cuid_pcg32_t r = cuid_pcg32_create();
+  uint32_t *numbers = malloc(batch * sizeof(uint32_t));
+  for (size_t done = 0; done < count; done += batch) {
+    size_t const n = count - done < batch ? count - done : batch;
+    cuid_pcg32_fill_ptr(&r, numbers, n);
+    cuid_bench_sink += numbers[n - 1];
+  }
+  free(numbers);
+}
+
+static void
+cuid_bench_pcg32_next(size_t count, size_t batch) {
+  cuid_pcg32_t r = cuid_pcg32_create();
+  for (size_t i = 0; i < count; ++i) {
+    cuid_pcg32_next_ptr(&r);
+    cuid_bench_sink += cuid_pcg32_read_ptr(&r);
+  }
+}
+
+/*
+** The thread entry point, runs the benchmark described by its argument.
+*/
+typedef struct cuid_bench_run_t {
+  cuid_bench_fn fn;
+  size_t count;
+  size_t batch;
+} cuid_bench_run_t;
+
+static void *
+cuid_bench_thread(void *arg) {
+  cuid_bench_run_t const *run = arg;
+  run->fn(run->count, run->batch);
+  return 0x0;
+}
+
+/*
+** Runs a benchmark in `threads` threads, each doing `count` operations,
+** and prints its results.
+*/
+static void
+cuid_bench_report(char const *name, cuid_bench_fn fn, size_t threads,
+                  size_t batch, size_t count, int json) {
+  cuid_bench_run_t run = { fn, count, batch };
+  pthread_t thread_ids[64];
+  threads = threads > 64 ? 64 : threads;
+  uint64_t const start_cycles = cuid_bench_cycles();
+  uint64_t const start = cuid_bench_ns();
+  if (threads == 1) {
+    fn(count, batch);
+  } else {
+    for (size_t t = 0; t < threads; ++t) {
+      pthread_create(&thread_ids[t], 0x0, cuid_bench_thread, &run);
+    }
+    for (size_t t = 0; t < threads; ++t) {
+      pthread_join(thread_ids[t], 0x0);
+    }
+  }
+  uint64_t const elapsed = cuid_bench_ns() - start;
+  uint64_t const cycles = cuid_bench_cycles() - start_cycles;
+
+  double const ns_per_op = (double)elapsed / (double)count;
+  double const ops_per_sec = (double)(count * threads) * 1e9 / (double)elapsed;
+  double const cycles_per_op = (double)cycles / (double)count;
+  if (json) {
+    printf("{\"name\":\"%s\",\"threads\":%zu,\"batch\":%zu,\"count\":%zu,"
+           "\"ns_per_op\":%.3f,\"ops_per_sec\":%.0f,\"cycles_per_op\":%.2f}\n",
+           name, threads, batch, count, ns_per_op, ops_per_sec,
+           cycles_per_op);
+  } else {
+    printf("%s,%zu,%zu,%zu,%.3f,%.0f,%.2f\n", name, threads, batch, count,
+           ns_per_op, ops_per_sec, cycles_per_op);
+  }
+}
+
+/*
+** The main() function is included to be able to run the cuid benchmarks
+** directly in the CLI.
+*/
+int main(int argc, char* argv[]) {
+  size_t count = 1000000;
+  int json = 0;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--json") == 0) {
+      json = 1;
+    } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      count = (size_t)strtoull(argv[++i], 0x0, 10);
+    }
+  }
+  if (!json) {
+    printf("name,threads,batch,count,ns_per_op,ops_per_sec,cycles_per_op\n");
+  }
+
+  static size_t const threads[] = { 1, 2, 4, 8 };
+  static size_t const batches[] = { 1, 16, 256, 4096 };
+  size_t const n_threads = sizeof threads / sizeof threads[0];
+  size_t const n_batches = sizeof batches / sizeof batches[0];
+
+  for (size_t t = 0; t < n_threads; ++t) {
+    cuid_bench_report("cuid", cuid_bench_cuid, threads[t], 1, count, json);
+  }
+  for (size_t t = 0; t < n_threads; ++t) {
+    for (size_t b = 0; b < n_batches; ++b) {
+      cuid_bench_report("cuid_n", cuid_bench_cuid_n, threads[t], batches[b],
+                        count, json);
+    }
+  }
+  // The pure API copies its state by value, fewer iterations keep it short
+  cuid_bench_report("cuid_next+cuid_read", cuid_bench_pure_value, 1, 1,
+                    count / 100 + 1, json);
+  for (size_t t = 0; t < n_threads; ++t) {
+    cuid_bench_report("cuid_next_inplace+cuid_read_ptr",
+                      cuid_bench_pure_inplace, threads[t], 1, count, json);
+  }
+  for (size_t t = 0; t < n_threads; ++t) {
+    for (size_t b = 0; b < n_batches; ++b) {
+      cuid_bench_report("cuid_generate_n", cuid_bench_generate_n, threads[t],
+                        batches[b], count, json);
+    }
+  }
+#ifdef CUID_ARENA
+  for (size_t b = 0; b < n_batches; ++b) {
+    cuid_bench_report("cuid_arena_next", cuid_bench_arena_next, 1,
+                      batches[b] * 16, count, json);
+  }
+#endif /* CUID_ARENA */
+#ifdef CUID_SHM
+  for (size_t t = 0; t < n_threads; ++t) {
+    cuid_bench_report("cuid_shm_next", cuid_bench_shm_next, threads[t], 1,
+                      count, json);
+  }
+#endif /* CUID_SHM */
+  cuid_bench_report("cuid_base36", cuid_bench_base36, 1, 1, count, json);
+  cuid_bench_report("cuid_base36_pad", cuid_bench_base36_pad, 1, 1, count,
+                    json);
+  cuid_bench_report("cuid_base36_block", cuid_bench_base36_block, 1, 1,
+                    count, json);
+  for (size_t b = 0; b < n_batches; ++b) {
+    cuid_bench_report("cuid_base36_blocks", cuid_bench_base36_blocks, 1,
+                      batches[b], count, json);
+  }
+  cuid_bench_report("cuid_hash", cuid_bench_hash, 1, 1, count, json);
+  cuid_bench_report("cuid_compare", cuid_bench_compare, 1, 1, count, json);
+  cuid_bench_report("mwc_next_random", cuid_bench_mwc_next_random, 1, 1,
+                    count / 100 + 1, json);
+  cuid_bench_report("mwc_next_random_ptr", cuid_bench_mwc_next_random_ptr, 1,
+                    1, count, json);
+  cuid_bench_report("cuid_pcg32_next", cuid_bench_pcg32_next, 1, 1, count,
+                    json);
+  for (size_t b = 0; b < n_batches; ++b) {
+    cuid_bench_report("mwc_fill", cuid_bench_mwc_fill, 1, batches[b], count,
+                      json);
+  }
+  for (size_t b = 0; b < n_batches; ++b) {
+    cuid_bench_report("cuid_pcg32_fill", cuid_bench_pcg32_fill, 1,
+                      batches[b], count, json);
+  }
+
+  return 0;
+}
+#endif /* CUID_BENCH_H */
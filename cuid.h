@@ -42,6 +42,38 @@
 #include <stddef.h> // size_t
 #include <stdint.h> // uint32_t, uint8_t, uint64_t
 #include <stdio.h> // perror
+#include <limits.h> // ULONG_MAX
+#ifdef CUID_THREADS
+/*
+** CUID_ATOMIC(T) is the type of the atomic variables, `_Atomic(T)` in C.
+** C++ has no `_Atomic` before C++23, so it is `std::atomic<T>` there, whose
+** free functions (`atomic_load_explicit`, ...) are found by argument
+** dependent lookup, and the memory orders are brought into scope.
+*/
+#ifdef __cplusplus
+#include <atomic> // std::atomic, std::memory_order
+#define CUID_ATOMIC(T) std::atomic<T>
+using std::memory_order_relaxed;
+using std::memory_order_acquire;
+using std::memory_order_release;
+using std::memory_order_acq_rel;
+#else
+#include <stdatomic.h> // _Atomic, atomic_fetch_add_explicit
+#define CUID_ATOMIC(T) _Atomic(T)
+#endif /* __cplusplus */
+#endif /* CUID_THREADS */
+
+/*
+** The array parameters are declared with `[static N]` in C to tell that the
+** array has at least N elements. C++ has no such declarator, so CUID_STATIC
+** is empty when compiling as C++.
+*/
+#ifdef __cplusplus
+#define CUID_STATIC
+#else
+#define CUID_STATIC static
+#endif /* __cplusplus */
+
 /*-- MARK: Public API Implementation -----------------------------------------*/
 #ifdef __cplusplus
 extern "C" {
@@ -49,25 +81,226 @@ extern "C" {
 
 /*
 ** The main `cuid()` function. This function is intended to be called as
-** a standalone function. It makes use of `static` vars within its block.
+** a standalone function. It makes use of `static` vars for its counter and
+** fingerprint cache, these are per-thread when CUID_THREADS is defined.
 **
 ** It calls the following functions:
 ** - The fingerprint function defined by `CUID_GET_FINGERPRINT`.
 ** - The timestamp function defined by `CUID_GET_TIMESTAMP`.
-** - The random function defined by `MWC_SYSTEM_RAND32`.
+** - The random function defined by `MWC_SYSTEM_RAND32`, or the buffered
+**   `CUID_SYSTEM_RANDOM_BUF` when CUID_BUFFERED_RANDOM is defined.
 **
 ** It is recommended that the pure interface provided below is used instead,
 ** however, for effortless and quick generation of cuid's this function does
 ** its job.
 **
 ** It receives the char array where the generated cuid will be placed at.
-** The resulting cuid is '\0' terminated and a length of 23 chars + '\0'.
+** The resulting cuid is '\0' terminated and a length of 23 chars + '\0'
+** (CUID_SIZE chars with the '\0').
 **
 ** This function returns the length of the final cuid string written to the
 ** result array.
 */
-#define CUID_SIZE (24)
-size_t cuid(char result[static CUID_SIZE]);
+
+/*
+** The layout of a cuid: the letter 'c', a timestamp block of
+** CUID_TIMESTAMP_LENGTH chars (6 by default, 8 with CUID_ORDERED) and the
+** counter, fingerprint and two random blocks of CUID_BLOCK_LENGTH (4) chars
+** each.
+**
+** Define CUID_TIMESTAMP_LENGTH, from 1 to 8, to change the size of the
+** timestamp block, all of the sizes and block offsets below follow it and
+** are compile time constants, so the formatting is specialized for them by
+** the compiler.
+*/
+#ifndef CUID_TIMESTAMP_LENGTH
+#ifdef CUID_ORDERED
+#define CUID_TIMESTAMP_LENGTH 8
+#else
+#define CUID_TIMESTAMP_LENGTH 6
+#endif /* CUID_ORDERED */
+#endif /* CUID_TIMESTAMP_LENGTH */
+#if CUID_TIMESTAMP_LENGTH < 1 || CUID_TIMESTAMP_LENGTH > 8
+#error "CUID_TIMESTAMP_LENGTH must be from 1 to 8"
+#endif
+#if defined(CUID_ORDERED) && CUID_TIMESTAMP_LENGTH < 8
+#error "CUID_ORDERED needs 8 chars for its milliseconds timestamp block"
+#endif
+#define CUID_BLOCK_LENGTH 4
+#define CUID_SIZE (1 + CUID_TIMESTAMP_LENGTH + 4 * CUID_BLOCK_LENGTH + 1)
+// The position of each block in a cuid
+#define CUID_TIMESTAMP_OFFSET 1
+#define CUID_COUNTER_OFFSET (CUID_TIMESTAMP_OFFSET + CUID_TIMESTAMP_LENGTH)
+#define CUID_FINGERPRINT_OFFSET (CUID_COUNTER_OFFSET + CUID_BLOCK_LENGTH)
+#define CUID_RANDOM1_OFFSET (CUID_FINGERPRINT_OFFSET + CUID_BLOCK_LENGTH)
+#define CUID_RANDOM2_OFFSET (CUID_RANDOM1_OFFSET + CUID_BLOCK_LENGTH)
+
+size_t cuid(char result[CUID_STATIC CUID_SIZE]);
+
+/*
+** The counter block of a cuid has 4 chars, it wraps around after
+** CUID_COUNTER_MAX (36^4) values. More cuids than this with the same
+** timestamp only differ by their random blocks.
+**
+** Define the macro CUID_WRAP_POLICY to choose what `cuid()` and `cuid_n()`
+** do when the counter would wrap around within the same timestamp:
+** - CUID_WRAP_IGNORE (the default): nothing, the counter wraps around.
+** - CUID_WRAP_SPIN: wait for CUID_GET_TIMESTAMP to return a new timestamp.
+** - CUID_WRAP_FAIL: stop generating, `cuid()` returns 0 and writes an empty
+**   string and `cuid_n()` returns the number of cuids written until then.
+**
+** With CUID_THREADS the check is done once per reserved counter range, so it
+** does not touch the hot path of each cuid.
+*/
+#define CUID_COUNTER_MAX (1679616U)
+#define CUID_WRAP_IGNORE 0
+#define CUID_WRAP_SPIN 1
+#define CUID_WRAP_FAIL 2
+#ifndef CUID_WRAP_POLICY
+#define CUID_WRAP_POLICY CUID_WRAP_IGNORE
+#endif /* CUID_WRAP_POLICY */
+
+/*
+** Define the macro CUID_THREADS to make `cuid()` safe to call from multiple
+** threads.
+**
+** In this mode each thread keeps its own counter and fingerprint cache in
+** thread local storage. The counter values are reserved from a shared atomic
+** counter in ranges of CUID_COUNTER_RANGE values, so counters stay unique
+** across threads and each thread only touches the shared counter once per
+** range.
+**
+** CUID_THREAD_LOCAL is the storage class used for the per-thread state, it
+** is empty when CUID_THREADS is not defined.
+*/
+#ifdef CUID_THREADS
+#ifndef CUID_THREAD_LOCAL
+#ifdef __cplusplus
+#define CUID_THREAD_LOCAL thread_local
+#else
+#define CUID_THREAD_LOCAL _Thread_local
+#endif
+#endif /* CUID_THREAD_LOCAL */
+#ifndef CUID_COUNTER_RANGE
+#define CUID_COUNTER_RANGE (1024U)
+#endif /* CUID_COUNTER_RANGE */
+#else
+#define CUID_THREAD_LOCAL
+#endif /* CUID_THREADS */
+
+/*
+** Generates `n` cuids into the `result` array, each one '\0' terminated.
+**
+** This shares the counter with `cuid()`, but the timestamp and fingerprint
+** functions are only called once for the whole batch.
+**
+** The counter and random blocks are made and formatted in chunks of
+** CUID_BATCH_CHUNK cuids (64 by default), kept on the stack, like the ones
+** of `cuid_generate_stride`.
+**
+** Returns the number of cuids written.
+*/
+#ifndef CUID_BATCH_CHUNK
+#define CUID_BATCH_CHUNK (64)
+#endif /* CUID_BATCH_CHUNK */
+size_t cuid_n(char result[][CUID_SIZE], size_t n);
+
+/*
+** The `cuid()` and `cuid_n()` functions call `CUID_GET_FINGERPRINT` only once
+** and keep its result in a cache, since the default fingerprint only changes
+** when the process pid changes.
+**
+** Call this function to clear the cache and have the fingerprint function
+** called again at the next cuid, e.g. in the child process after a `fork()`.
+**
+** If the macro CUID_FORK_SAFE is defined this is done automatically with a
+** `pthread_atfork()` handler, registered when the fingerprint is first
+** cached.
+*/
+void cuid_fingerprint_reset(void);
+
+/*
+** Define the macro CUID_BUFFERED_RANDOM to have `cuid()` and `cuid_n()` take
+** their random numbers from a buffer of CUID_RANDOM_BUFFER_SIZE bytes (4096
+** by default, per thread with CUID_THREADS), refilled when empty by the
+** CUID_SYSTEM_RANDOM_BUF function (`arc4random_buf` by default), instead of
+** one MWC_SYSTEM_RAND32 call per number.
+**
+** CUID_SYSTEM_RANDOM_BUF receives the buffer and its size in bytes, as
+** `void CUID_SYSTEM_RANDOM_BUF(void *, size_t);`
+**
+** Call this function to discard the numbers left in the buffer, e.g. in the
+** child process after a `fork()`, so it does not produce the same numbers as
+** the parent. This is done automatically by a `pthread_atfork()` handler,
+** registered at the first refill, where the POSIX threads are available
+** (`_POSIX_THREADS`).
+*/
+void cuid_random_reset(void);
+
+/*
+** Define the macro CUID_STATS to count what the generators do, the counters
+** are compiled out otherwise.
+**
+** Each `cuid_t` of the pure API keeps its own counters, read them with
+** `cuid_stats_read`, and `cuid()` and `cuid_n()` keep them per thread with
+** CUID_THREADS, read them with `cuid_thread_stats`. The counters are only
+** written by their owner, each event costs a plain increment. Sum the
+** snapshots of many threads or states with `cuid_stats_add`, and take the
+** difference of two snapshots for the rates.
+**
+** The counters are the cuids generated, the times the counter block went
+** back to 0 (or that CUID_WRAP_POLICY kept it from doing so within the same
+** timestamp), the times the timestamp block changed, the random number
+** refills (the blocks filled by the batch functions, the buffer refills of
+** CUID_BUFFERED_RANDOM) and the reseeds.
+*/
+typedef struct cuid_stats_t {
+  uint64_t cuid_generated;
+  uint64_t cuid_counter_wraps;
+  uint64_t cuid_timestamp_changes;
+  uint64_t cuid_random_refills;
+  uint64_t cuid_reseeds;
+} cuid_stats_t;
+
+#ifdef CUID_STATS
+#define CUID_STATS_ADD(stats, field, n) ((stats)->field += (n))
+#else
+#define CUID_STATS_ADD(stats, field, n) ((void)(n))
+#endif /* CUID_STATS */
+
+/*
+** Adds the counters of `stats` to the ones of `total`.
+*/
+static inline void
+cuid_stats_add(cuid_stats_t *total, cuid_stats_t const *stats) {
+  total->cuid_generated += stats->cuid_generated;
+  total->cuid_counter_wraps += stats->cuid_counter_wraps;
+  total->cuid_timestamp_changes += stats->cuid_timestamp_changes;
+  total->cuid_random_refills += stats->cuid_random_refills;
+  total->cuid_reseeds += stats->cuid_reseeds;
+}
+
+/*
+** Places the counters of `cuid()` and `cuid_n()` in the calling thread (or
+** in the process without CUID_THREADS) in `stats`. They are all 0 without
+** CUID_STATS.
+*/
+void cuid_thread_stats(cuid_stats_t *stats);
+
+/*
+** Define CUID_TRACE_BEGIN and CUID_TRACE_END to feed a tracer, they are
+** called at the start and at the end of `cuid()`, `cuid_n()`,
+** `cuid_next_inplace` and `cuid_generate_stride` with the name of the
+** function as a string literal, and in `cuid()` and `cuid_n()` around the
+** calls to get the "timestamp", the "fingerprint" and the "random" numbers.
+** Both are empty by default.
+*/
+#ifndef CUID_TRACE_BEGIN
+#define CUID_TRACE_BEGIN(name) ((void)0)
+#endif /* CUID_TRACE_BEGIN */
+#ifndef CUID_TRACE_END
+#define CUID_TRACE_END(name) ((void)0)
+#endif /* CUID_TRACE_END */
 
 /*
 ** Provide your timestamp function and define it as CUID_GET_TIMESTAMP.
@@ -75,17 +308,179 @@ size_t cuid(char result[static CUID_SIZE]);
 ** a `unsigned long` number.
 **
 ** The default is `time()` from the <time.h> C standard lib.
+**
+** Define the macro CUID_COARSE_TIMESTAMP to use `cuid_get_timestamp_coarse`
+** instead, it reads the seconds from `clock_gettime()` with the
+** CLOCK_REALTIME_COARSE clock where available (Linux), which is served from
+** the vDSO without a syscall, or CLOCK_REALTIME otherwise.
+**
+** Define the macro CUID_ORDERED for time ordered (k-sortable) cuids. The
+** timestamp is then the milliseconds since the epoch, from
+** `cuid_get_timestamp_ms`, in a timestamp block of 8 chars (enough until the
+** year 2059). Since the base36 digits sort as their ASCII chars, cuids made
+** with a greater timestamp, or with the same timestamp and a greater
+** counter, are greater strings. In this mode the pure API and the shared
+** generator start the counter again at each new timestamp, never take a
+** timestamp older than the one of their previous cuid, and move on to the
+** next millisecond when the counter block of a timestamp is full, so each
+** generator makes strictly increasing cuids. The `cuid()` and `cuid_n()`
+** functions take the milliseconds timestamp too, but they keep their counter
+** going (it is handed to the threads in ranges), so their cuids are only
+** ordered by their millisecond.
 */
-#ifndef CUID_GET_TIMESTAMP
-#include <time.h> // time()
+#include <time.h> // time(), clock_gettime()
+#if defined(CUID_ORDERED) && ULONG_MAX <= 0xFFFFFFFFUL
+#error "CUID_ORDERED needs an unsigned long of 64 bits for its timestamps"
+#endif
+
+#ifdef CLOCK_REALTIME
+static inline unsigned long
+cuid_get_timestamp_coarse(void) {
+  struct timespec now = {0, 0};
+#ifdef CLOCK_REALTIME_COARSE
+  clock_gettime(CLOCK_REALTIME_COARSE, &now);
+#else
+  clock_gettime(CLOCK_REALTIME, &now);
+#endif /* CLOCK_REALTIME_COARSE */
+  return (unsigned long)now.tv_sec;
+}
+
+static inline unsigned long
+cuid_get_timestamp_ms(void) {
+  struct timespec now = {0, 0};
+  clock_gettime(CLOCK_REALTIME, &now);
+  return (unsigned long)now.tv_sec * 1000UL
+       + (unsigned long)now.tv_nsec / 1000000UL;
+}
+#endif /* CLOCK_REALTIME */
 
+#ifndef CUID_GET_TIMESTAMP
+#if defined(CUID_ORDERED) && defined(CLOCK_REALTIME)
+#define CUID_GET_TIMESTAMP cuid_get_timestamp_ms
+#elif defined(CUID_COARSE_TIMESTAMP) && defined(CLOCK_REALTIME)
+#define CUID_GET_TIMESTAMP cuid_get_timestamp_coarse
+#else
 static inline unsigned long
 cuid_get_timestamp(void) {
   return (unsigned long)time(0x0);
 }
 #define CUID_GET_TIMESTAMP cuid_get_timestamp
+#endif /* CUID_COARSE_TIMESTAMP */
 #endif /* CUID_GET_TIMESTAMP */
 
+/*
+** The system random function, it should receive no arguments and return a
+** `uint32_t`. It is used by `cuid()` for the random blocks and by the pure
+** API random number generators to create their initial state.
+**
+** The default is `arc4random()`.
+*/
+#ifndef MWC_SYSTEM_RAND32
+#include <stdlib.h> // arc4random()
+#define MWC_SYSTEM_RAND32 arc4random
+#endif /* MWC_SYSTEM_RAND32 */
+
+/*
+** Table used to convert a number to base 36.
+*/
+static char const cuid_base36_digits[] =
+  "0123456789abcdefghijklmnopqrstuvwxyz";
+
+/*
+** Table with all of the 2 char base36 strings, from "00" to "zz".
+** The base36 string for a number `n < 1296` is at `&cuid_base36_pairs[2 * n]`,
+** this allows two digits to be converted with a single division.
+*/
+#define CUID_BASE36_ROW(d) \
+  d "0" d "1" d "2" d "3" d "4" d "5" d "6" d "7" d "8" d "9" d "a" d "b" \
+  d "c" d "d" d "e" d "f" d "g" d "h" d "i" d "j" d "k" d "l" d "m" d "n" \
+  d "o" d "p" d "q" d "r" d "s" d "t" d "u" d "v" d "w" d "x" d "y" d "z"
+static char const cuid_base36_pairs[] =
+  CUID_BASE36_ROW("0") CUID_BASE36_ROW("1") CUID_BASE36_ROW("2")
+  CUID_BASE36_ROW("3") CUID_BASE36_ROW("4") CUID_BASE36_ROW("5")
+  CUID_BASE36_ROW("6") CUID_BASE36_ROW("7") CUID_BASE36_ROW("8")
+  CUID_BASE36_ROW("9") CUID_BASE36_ROW("a") CUID_BASE36_ROW("b")
+  CUID_BASE36_ROW("c") CUID_BASE36_ROW("d") CUID_BASE36_ROW("e")
+  CUID_BASE36_ROW("f") CUID_BASE36_ROW("g") CUID_BASE36_ROW("h")
+  CUID_BASE36_ROW("i") CUID_BASE36_ROW("j") CUID_BASE36_ROW("k")
+  CUID_BASE36_ROW("l") CUID_BASE36_ROW("m") CUID_BASE36_ROW("n")
+  CUID_BASE36_ROW("o") CUID_BASE36_ROW("p") CUID_BASE36_ROW("q")
+  CUID_BASE36_ROW("r") CUID_BASE36_ROW("s") CUID_BASE36_ROW("t")
+  CUID_BASE36_ROW("u") CUID_BASE36_ROW("v") CUID_BASE36_ROW("w")
+  CUID_BASE36_ROW("x") CUID_BASE36_ROW("y") CUID_BASE36_ROW("z");
+#undef CUID_BASE36_ROW
+
+/*
+** Writes the lowest `width` base36 digits of `cuid_number` into the
+** `cuid_result` array, zero padded on the left.
+** The digits are written straight into place from right to left, no '\0' is
+** written at the end.
+*/
+static inline void
+cuid_base36_fixed(uint64_t cuid_number, char *cuid_result, size_t width) {
+  while (width >= 2) {
+    uint64_t const quotient = cuid_number / 1296;
+    size_t const pair = 2 * (size_t)(cuid_number - quotient * 1296);
+    width -= 2;
+    cuid_result[width] = cuid_base36_pairs[pair];
+    cuid_result[width + 1] = cuid_base36_pairs[pair + 1];
+    cuid_number = quotient;
+  }
+  if (width == 1) {
+    cuid_result[0] = cuid_base36_digits[cuid_number % 36];
+  }
+}
+
+/*
+** Writes the lowest 4 base36 digits of a 32 bit number into `cuid_result`,
+** this is the size of the counter and random blocks of a cuid.
+** No '\0' is written at the end.
+*/
+static inline void
+cuid_base36_block(uint32_t cuid_number, char *cuid_result) {
+  uint32_t const quotient = cuid_number / 1296;
+  size_t const low = 2 * (size_t)(cuid_number - quotient * 1296);
+  size_t const high = 2 * (size_t)(quotient % 1296);
+  cuid_result[0] = cuid_base36_pairs[high];
+  cuid_result[1] = cuid_base36_pairs[high + 1];
+  cuid_result[2] = cuid_base36_pairs[low];
+  cuid_result[3] = cuid_base36_pairs[low + 1];
+}
+
+// The powers of 36 that fit in a uint64_t
+static uint64_t const cuid_base36_powers[] = {
+  1ULL, 36ULL, 1296ULL, 46656ULL, 1679616ULL, 60466176ULL, 2176782336ULL,
+  78364164096ULL, 2821109907456ULL, 101559956668416ULL,
+  3656158440062976ULL, 131621703842267136ULL, 4738381338321616896ULL
+};
+
+/*
+** Defines `cuid_base36_<name>(number, result)`, a base36 encoder of a fixed
+** `width` (see `cuid_base36_fixed`). The width is a constant in its body so
+** the compiler fully unrolls it.
+*/
+#define CUID_BASE36_FIXED_ENCODER(name, width)                              \
+  static inline void                                                        \
+  cuid_base36_##name(uint64_t const cuid_number, char *cuid_result) {       \
+    cuid_base36_fixed(cuid_number, cuid_result, (width));                   \
+  }
+
+// The encoder of the timestamp block
+CUID_BASE36_FIXED_ENCODER(timestamp, CUID_TIMESTAMP_LENGTH)
+
+/*
+** Returns the number of base36 digits needed for `cuid_number`.
+*/
+static inline size_t
+cuid_base36_length(uint64_t const cuid_number) {
+  size_t length = 1;
+  while (length < sizeof cuid_base36_powers / sizeof cuid_base36_powers[0]
+         && cuid_number >= cuid_base36_powers[length]) {
+    length++;
+  }
+  return length;
+}
+
 /*
 ** Converts a number to a base36 string.
 ** Places the resulting string in the array provided as argument.
@@ -94,25 +489,9 @@ cuid_get_timestamp(void) {
 #define CUID_BASE36_RESULT_SIZE 16
 static inline size_t
 cuid_base36(uint64_t cuid_number,
-            char cuid_result[static CUID_BASE36_RESULT_SIZE]) {
-  // Table used to convert a number to base 36.
-  static char const cuid_radix36_table[] =
-    "0123456789abcdefghijklmnopqrstuvwxyz";
-
-  char cuid_inverted_result[CUID_BASE36_RESULT_SIZE] = {0};
-  size_t const base = sizeof cuid_radix36_table - 1;
-  size_t cuid_length = 0;
-
-  do {
-    cuid_inverted_result[cuid_length] = cuid_radix36_table[cuid_number % base];
-    cuid_number /= base;
-    cuid_length++;
-  } while (cuid_number > 0 && cuid_length < CUID_BASE36_RESULT_SIZE - 1);
-
-  // Invert the result
-  for (size_t i = 0; i <= cuid_length - 1; ++i) {
-    cuid_result[i] = cuid_inverted_result[cuid_length - 1 - i];
-  }
+            char cuid_result[CUID_STATIC CUID_BASE36_RESULT_SIZE]) {
+  size_t const cuid_length = cuid_base36_length(cuid_number);
+  cuid_base36_fixed(cuid_number, cuid_result, cuid_length);
   cuid_result[cuid_length] = '\0';
 
   return cuid_length;
@@ -120,6 +499,8 @@ cuid_base36(uint64_t cuid_number,
 
 /*
 ** A padded version of base36.
+** Writes exactly `pad_length` chars followed by a '\0', numbers with more
+** digits than `pad_length` are clipped to their last `pad_length` digits.
 ** Makes use of CUID_EXIT which by default is set at the `exit()` from
 ** `<stdlib.h>` 
 */
@@ -129,7 +510,7 @@ cuid_base36(uint64_t cuid_number,
 #endif // CUID_EXIT
 static inline size_t
 cuid_base36_pad(uint64_t cuid_number,
-                char cuid_result[static CUID_BASE36_RESULT_SIZE],
+                char cuid_result[CUID_STATIC CUID_BASE36_RESULT_SIZE],
                 uint8_t const pad_length,
                 char const pad_char) {
   if (pad_length >= CUID_BASE36_RESULT_SIZE) {
@@ -137,28 +518,281 @@ cuid_base36_pad(uint64_t cuid_number,
            "than the provided cuid_result array length");
     CUID_EXIT(EXIT_FAILURE);
   }
-  size_t const base36_str_len = cuid_base36(cuid_number, cuid_result);
-
-  // Check if padding adjustment is necessary
-  if (base36_str_len < pad_length) {
-    // Shift all characters to the right, and fill the rest with the
-    // pad_char
-    for (size_t i = 0; i <= pad_length; ++i) {
-      cuid_result[pad_length - i] = i > base36_str_len ? pad_char
-                                  : cuid_result[base36_str_len - i];
-    }
-  } else if (base36_str_len > pad_length) {
-    // Clip at the end of the string by moving all characters to
-    // the left
-    size_t const diff = base36_str_len - pad_length;
-    for (size_t i = 0; i <= pad_length; ++i) {
-      cuid_result[i] = cuid_result[i + diff];
+  size_t digits = pad_length;
+  if (pad_char != '0') {
+    // Fill the left side with the pad_char
+    size_t const base36_str_len = cuid_base36_length(cuid_number);
+    if (base36_str_len < pad_length) {
+      digits = base36_str_len;
+      for (size_t i = 0; i < pad_length - digits; ++i) {
+        cuid_result[i] = pad_char;
+      }
     }
   }
+  cuid_base36_fixed(cuid_number, &cuid_result[pad_length - digits], digits);
+  cuid_result[pad_length] = '\0';
   return pad_length;
 }
 
 
+/*
+** A cache of the encoded timestamp block.
+**
+** Timestamps only change once per second (once per millisecond with
+** CUID_ORDERED), `cuid_timestamp_cache_update` only encodes a timestamp when
+** it is newer than the cached one, so the cuids made within the same second
+** (or millisecond) can just copy the cached block.
+**
+** The cache never moves backwards: a timestamp older than the cached one
+** (e.g. after the clock was adjusted) keeps the cached block, which keeps
+** the cuids generated with it in order.
+**
+** Initialize it with CUID_TIMESTAMP_CACHE_INIT.
+*/
+typedef struct cuid_timestamp_cache_t {
+  unsigned long value;
+  char block[CUID_TIMESTAMP_LENGTH];
+} cuid_timestamp_cache_t;
+
+#define CUID_TIMESTAMP_CACHE_INIT { 0, { 0 } }
+
+/*
+** Updates the cache with the provided timestamp.
+** Returns 1 if the block was encoded again, 0 if the cached one was kept.
+*/
+static inline int
+cuid_timestamp_cache_update(cuid_timestamp_cache_t *cache,
+                            unsigned long const timestamp) {
+  if (timestamp > cache->value || cache->block[0] == '\0') {
+    cuid_base36_timestamp(timestamp, cache->block);
+    cache->value = timestamp;
+    return 1;
+  }
+  return 0;
+}
+
+/*
+** Batch conversion of 32 bit numbers into 4 char base36 blocks.
+**
+** `cuid_base36_blocks` writes the same chars as calling `cuid_base36_block`
+** for each of the `n` values, placing the block of `values[i]` at
+** `&out[i * stride]`. This is used by the batch generation functions to
+** format a whole column of counters or random numbers at once.
+**
+** SIMD versions are provided for SSE2 and AVX2 (x86_64) and for NEON
+** (aarch64), with a scalar fallback for the remaining targets and the tail
+** of each batch. The version used is selected at runtime, see
+** `cuid_kernels`.
+** Define the macro CUID_NO_SIMD to always use the scalar version.
+**
+** The SIMD versions divide by 1296 by multiplying `v >> 4` by
+** ceil(2^38 / 81) and shifting by 38, which is exact for all 32 bit numbers,
+** and then split each pair of digits `x < 1296` with `(x * 1821) >> 16`.
+*/
+static inline void
+cuid_base36_blocks_scalar(uint32_t const *values,
+                          size_t const n,
+                          char *out,
+                          size_t const stride) {
+  for (size_t i = 0; i < n; ++i) {
+    cuid_base36_block(values[i], &out[i * stride]);
+  }
+}
+
+#if !defined(CUID_NO_SIMD) && defined(__x86_64__) \
+    && (defined(__GNUC__) || defined(__clang__))
+#define CUID_SIMD_X86 (1)
+#include <immintrin.h> // SSE2 and AVX2 intrinsics
+
+/*
+** Places 4 blocks in the output, 4 bytes each from the `chars` array.
+*/
+static inline void
+cuid_base36_blocks_scatter(uint8_t const chars[CUID_STATIC 16],
+                           char *out,
+                           size_t const stride) {
+  for (size_t i = 0; i < 4; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      out[i * stride + j] = (char)chars[i * 4 + j];
+    }
+  }
+}
+
+// Returns `v / 1296` for each of the 32 bit lanes
+static inline __m128i
+cuid_sse2_div1296(__m128i const v) {
+  __m128i const magic = _mm_set1_epi32((int)3393554408U);
+  __m128i const x = _mm_srli_epi32(v, 4);
+  __m128i const even = _mm_srli_epi64(_mm_mul_epu32(x, magic), 38);
+  __m128i const odd = _mm_srli_epi64(
+      _mm_mul_epu32(_mm_srli_epi64(x, 32), magic), 38);
+  return _mm_or_si128(even, _mm_slli_epi64(odd, 32));
+}
+
+// Returns `v * 1296` for each of the 32 bit lanes (1296 = 1024 + 256 + 16)
+static inline __m128i
+cuid_sse2_mul1296(__m128i const v) {
+  return _mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(v, 10),
+                                     _mm_slli_epi32(v, 8)),
+                       _mm_slli_epi32(v, 4));
+}
+
+// Returns the base36 char for each of the 16 bit lanes digits
+static inline __m128i
+cuid_sse2_digits(__m128i const d) {
+  __m128i const letters = _mm_and_si128(
+      _mm_cmpgt_epi16(d, _mm_set1_epi16(9)), _mm_set1_epi16('a' - '0' - 10));
+  return _mm_add_epi16(d, _mm_add_epi16(_mm_set1_epi16('0'), letters));
+}
+
+static inline void
+cuid_base36_blocks_sse2(uint32_t const *values,
+                        size_t const n,
+                        char *out,
+                        size_t const stride) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i const v =
+      _mm_loadu_si128((__m128i const *)(void const *)&values[i]);
+    // The two lowest pairs of digits,
+    // `low = v % 1296` and `high = v / 1296 % 1296`
+    __m128i const q = cuid_sse2_div1296(v);
+    __m128i const low = _mm_sub_epi32(v, cuid_sse2_mul1296(q));
+    __m128i const high = _mm_sub_epi32(q,
+        cuid_sse2_mul1296(cuid_sse2_div1296(q)));
+    // Split the pairs into digits, in 16 bit lanes
+    __m128i const pairs = _mm_packs_epi32(low, high);
+    __m128i const first = _mm_mulhi_epu16(pairs, _mm_set1_epi16(1821));
+    __m128i const second = _mm_sub_epi16(pairs,
+        _mm_mullo_epi16(first, _mm_set1_epi16(36)));
+    __m128i const chars = _mm_or_si128(cuid_sse2_digits(first),
+        _mm_slli_epi16(cuid_sse2_digits(second), 8));
+    // Interleave the high and low pairs of each block
+    __m128i const blocks = _mm_unpacklo_epi16(
+        _mm_unpackhi_epi64(chars, chars), chars);
+    uint8_t result[16];
+    _mm_storeu_si128((__m128i *)(void *)result, blocks);
+    cuid_base36_blocks_scatter(result, &out[i * stride], stride);
+  }
+  cuid_base36_blocks_scalar(&values[i], n - i, &out[i * stride], stride);
+}
+
+__attribute__((target("avx2"))) static inline __m256i
+cuid_avx2_div1296(__m256i const v) {
+  __m256i const magic = _mm256_set1_epi32((int)3393554408U);
+  __m256i const x = _mm256_srli_epi32(v, 4);
+  __m256i const even = _mm256_srli_epi64(_mm256_mul_epu32(x, magic), 38);
+  __m256i const odd = _mm256_srli_epi64(
+      _mm256_mul_epu32(_mm256_srli_epi64(x, 32), magic), 38);
+  return _mm256_or_si256(even, _mm256_slli_epi64(odd, 32));
+}
+
+__attribute__((target("avx2"))) static inline __m256i
+cuid_avx2_mul1296(__m256i const v) {
+  return _mm256_add_epi32(_mm256_add_epi32(_mm256_slli_epi32(v, 10),
+                                           _mm256_slli_epi32(v, 8)),
+                          _mm256_slli_epi32(v, 4));
+}
+
+__attribute__((target("avx2"))) static inline __m256i
+cuid_avx2_digits(__m256i const d) {
+  __m256i const letters = _mm256_and_si256(
+      _mm256_cmpgt_epi16(d, _mm256_set1_epi16(9)),
+      _mm256_set1_epi16('a' - '0' - 10));
+  return _mm256_add_epi16(d, _mm256_add_epi16(_mm256_set1_epi16('0'),
+                                              letters));
+}
+
+/*
+** The AVX2 version works as the SSE2 one, on 8 values at a time. The pack
+** and unpack instructions work within each 128 bit half, so each half holds
+** the blocks of 4 consecutive values.
+*/
+__attribute__((target("avx2"))) static inline void
+cuid_base36_blocks_avx2(uint32_t const *values,
+                        size_t const n,
+                        char *out,
+                        size_t const stride) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i const v = _mm256_loadu_si256(
+        (__m256i const *)(void const *)&values[i]);
+    __m256i const q = cuid_avx2_div1296(v);
+    __m256i const low = _mm256_sub_epi32(v, cuid_avx2_mul1296(q));
+    __m256i const high = _mm256_sub_epi32(q,
+        cuid_avx2_mul1296(cuid_avx2_div1296(q)));
+    __m256i const pairs = _mm256_packs_epi32(low, high);
+    __m256i const first = _mm256_mulhi_epu16(pairs, _mm256_set1_epi16(1821));
+    __m256i const second = _mm256_sub_epi16(pairs,
+        _mm256_mullo_epi16(first, _mm256_set1_epi16(36)));
+    __m256i const chars = _mm256_or_si256(cuid_avx2_digits(first),
+        _mm256_slli_epi16(cuid_avx2_digits(second), 8));
+    __m256i const blocks = _mm256_unpacklo_epi16(
+        _mm256_unpackhi_epi64(chars, chars), chars);
+    uint8_t result[32];
+    _mm256_storeu_si256((__m256i *)(void *)result, blocks);
+    cuid_base36_blocks_scatter(result, &out[i * stride], stride);
+    cuid_base36_blocks_scatter(&result[16], &out[(i + 4) * stride], stride);
+  }
+  cuid_base36_blocks_sse2(&values[i], n - i, &out[i * stride], stride);
+}
+
+#elif !defined(CUID_NO_SIMD) && defined(__aarch64__) \
+    && defined(__ARM_NEON)
+#define CUID_SIMD_NEON (1)
+#include <arm_neon.h> // NEON intrinsics
+
+// Returns `v / 1296` for each of the 32 bit lanes
+static inline uint32x4_t
+cuid_neon_div1296(uint32x4_t const v) {
+  uint32x4_t const x = vshrq_n_u32(v, 4);
+  uint64x2_t const low = vmull_n_u32(vget_low_u32(x), 3393554408U);
+  uint64x2_t const high = vmull_high_n_u32(x, 3393554408U);
+  return vcombine_u32(vmovn_u64(vshrq_n_u64(low, 38)),
+                      vmovn_u64(vshrq_n_u64(high, 38)));
+}
+
+// Returns the base36 char for each of the 16 bit lanes digits
+static inline uint16x8_t
+cuid_neon_digits(uint16x8_t const d) {
+  uint16x8_t const letters = vandq_u16(vcgtq_u16(d, vdupq_n_u16(9)),
+                                       vdupq_n_u16('a' - '0' - 10));
+  return vaddq_u16(d, vaddq_u16(vdupq_n_u16('0'), letters));
+}
+
+static inline void
+cuid_base36_blocks_neon(uint32_t const *values,
+                        size_t const n,
+                        char *out,
+                        size_t const stride) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    uint32x4_t const v = vld1q_u32(&values[i]);
+    uint32x4_t const q = cuid_neon_div1296(v);
+    uint32x4_t const low = vmlsq_n_u32(v, q, 1296);
+    uint32x4_t const high = vmlsq_n_u32(q, cuid_neon_div1296(q), 1296);
+    uint16x8_t const pairs = vcombine_u16(vmovn_u32(low), vmovn_u32(high));
+    uint16x8_t const first = vcombine_u16(
+        vshrn_n_u32(vmull_n_u16(vget_low_u16(pairs), 1821), 16),
+        vshrn_n_u32(vmull_high_n_u16(pairs, 1821), 16));
+    uint16x8_t const second = vmlsq_n_u16(pairs, first, 36);
+    uint16x8_t const chars = vorrq_u16(cuid_neon_digits(first),
+        vshlq_n_u16(cuid_neon_digits(second), 8));
+    uint16x4x2_t const blocks = vzip_u16(vget_high_u16(chars),
+                                         vget_low_u16(chars));
+    uint8_t result[16];
+    vst1q_u8(result, vreinterpretq_u8_u16(vcombine_u16(blocks.val[0],
+                                                       blocks.val[1])));
+    for (size_t b = 0; b < 4; ++b) {
+      for (size_t j = 0; j < 4; ++j) {
+        out[(i + b) * stride + j] = (char)result[b * 4 + j];
+      }
+    }
+  }
+  cuid_base36_blocks_scalar(&values[i], n - i, &out[i * stride], stride);
+}
+#endif /* CUID_NO_SIMD */
+
 /*
 ** Provide your fingerprint generation function and define it as
 ** CUID_GET_FINGERPRINT.
@@ -173,7 +807,7 @@ cuid_base36_pad(uint64_t cuid_number,
 #include <unistd.h> // gethostname, getpid
 
 static inline size_t
-cuid_get_fingerprint(char result[static CUID_FINGERPRINT_SIZE]) {
+cuid_get_fingerprint(char result[CUID_STATIC CUID_FINGERPRINT_SIZE]) {
 #define CUID_HOSTNAME_LENGTH 256
   // A different array is used for the hostname to prevent `gethostname` to
   // to return the ENAMETOOLONG error. A hostname max value is 256 chars,
@@ -200,98 +834,722 @@ cuid_get_fingerprint(char result[static CUID_FINGERPRINT_SIZE]) {
   for (size_t i = 0; i < CUID_HOSTNAME_LENGTH / 4; i++) {
     hostname_number += hostname.values[i];
   }
-  // Convert to base36
-  size_t length = cuid_base36_pad(hostname_number, result, 2, '0');
+  // Convert to base36, 2 chars for the hostname and 2 for the pid
+  cuid_base36_fixed(hostname_number, result, 2);
 
   uint64_t pid = (uint64_t)getpid();
-  // Returns the length of the base36 hostname
-  length += cuid_base36_pad(pid, &result[2], 2, '0');
-  return length;
+  cuid_base36_fixed(pid, &result[2], 2);
+  result[4] = '\0';
+  // Returns the length of the fingerprint
+  return 4;
 }
 
 #define CUID_GET_FINGERPRINT cuid_get_fingerprint
 
 #endif /* CUID_GET_FINGERPRINT */
 
-#ifdef CUID_PURE
+/*-- MARK: Parsing -----------------------------------------------------------*/
 /*
-** The cuid() pure API
-**
-** This is an optional API that provides a set of
-** functions that depend only on their arguments to create a cuid string. 
-** This can be useful if you want to partially build your cuid's or integrate
-** with some other language cuid library through its FFI.
-**
-** All functions are declared as static inline to prevent copies.
-** To use this library please set -DCUID_PURE in your compiler arguments
-** or define the CUID_PURE macro in the code that includes this .h file.
-**
+** Returns 1 if `c` is one of the lowercase base36 digits of a cuid.
 */
+static inline int
+cuid_base36_is_digit(unsigned const c) {
+  return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z');
+}
 
 /*
-** The counter is split in several functions, most of them are pure and
-** should have no side-effects:
-**
-** - CUID_CREATE_COUNTER: creates the CUID_COUNTER_T data type
-**   * with type: `COUNTER_T CREATE_COUNTER(void);`
-** - CUID_INIT_COUNTER: initializes the created CUID_COUNTER_T with the startup
-**   value(s)
-**   * with type: `CUID_COUNTER_T CUID_INIT_COUNTER(CUID_COUNTER_T);`
-** - CUID_READ_COUNTER: returns the counter value (unsigned int)
-**   * with type: `unsigned CUID_READ_COUNTER(CUID_COUNTER_T);`
-** - CUID_INCREASE_COUNTER: increases counter value 
-**   * with type: `CUID_COUNTER_T CUID_INCREASE_COUNTER(CUID_COUNTER_T);`
-**
-** In order to override the cuid counter with a specific implementation
-** please define them all, as well as the CUID_COUNTER_T type, be sure that
-** they can be called during startup as:
-**
-**   CUID_COUNTER_T c = CUID_INIT_COUNTER(CUID_CREATE_COUNTER())
-**
-** And then at each call as:
-**
-** CUID_COUNTER_T next_counter = CUID_INCREASE_COUNTER(c)
-** unsigned value = CUID_READ_COUNTER(next_counter)
-**
-** A default implementation is provided which increments a simple variable as
-** `c++;` // this is not subliminal
-**
+** Reads `width` base36 digits from `cuid_str` into `cuid_number`.
+** Only the lowercase digits written by the cuid encoders are accepted.
+** Returns 1 if all the digits are valid, 0 otherwise.
 */
-#ifndef CUID_COUNTER_T
-typedef struct cuid_counter_t {
-  unsigned value;
-} cuid_counter_t;
-#define CUID_COUNTER_T cuid_counter_t
+static inline int
+cuid_base36_decode(char const *cuid_str, size_t width, uint64_t *cuid_number) {
+  uint64_t number = 0;
+  for (size_t i = 0; i < width; i++) {
+    unsigned const c = (unsigned char)cuid_str[i];
+    if (!cuid_base36_is_digit(c)) {
+      return 0;
+    }
+    number = number * 36 + (c <= '9' ? c - '0' : c - 'a' + 10);
+  }
+  *cuid_number = number;
+  return 1;
+}
 
-static inline cuid_counter_t cuid_create_counter(void) {
-  return (cuid_counter_t){0};
+/*
+** Reads `width` base36 digits that are known to be valid, without branches.
+*/
+static inline uint64_t
+cuid_base36_decode_valid(char const *cuid_str, size_t width) {
+  uint64_t number = 0;
+  for (size_t i = 0; i < width; i++) {
+    uint64_t const c = (unsigned char)cuid_str[i];
+    number = number * 36 + c - '0' - ('a' - '0' - 10U) * (uint64_t)(c > '9');
+  }
+  return number;
 }
-#define CUID_CREATE_COUNTER cuid_create_counter
 
-static inline cuid_counter_t
-cuid_init_counter(cuid_counter_t c) {
-  c.value = 0U;
-  return c;
+/*
+** Checks that a string is a cuid: a 'c' followed by 22 base36 lowercase
+** digits and a '\0' at `cuid_str[CUID_SIZE - 1]`. All of the `CUID_SIZE`
+** bytes are read, but a string ending early is rejected by its '\0'.
+** Returns 1 if the string is a valid cuid, 0 otherwise.
+**
+** The SIMD versions check the string with two overlapping 16 byte loads, at
+** offsets 0 and CUID_SIZE - 16 (8 with the default layout). A byte is a
+** digit if `c - '0' < 10` and a letter if `c - 'a' < 26`, both unsigned
+** compares are done as signed compares after moving the range start to -128.
+*/
+static inline int
+cuid_validate_scalar(char const cuid_str[CUID_STATIC CUID_SIZE]) {
+  if (cuid_str[0] != 'c' || cuid_str[CUID_SIZE - 1] != '\0') {
+    return 0;
+  }
+  // Only the chars are checked, 22 digits do not fit in a number
+  for (size_t i = 1; i < CUID_SIZE - 1; ++i) {
+    if (!cuid_base36_is_digit((unsigned char)cuid_str[i])) {
+      return 0;
+    }
+  }
+  return 1;
 }
-#define CUID_INIT_COUNTER cuid_init_counter
 
-static inline unsigned
-cuid_read_counter(cuid_counter_t const c) {
-  return c.value;
+#if defined(CUID_SIMD_X86)
+// Returns the mask of the bytes of `v` that are base36 lowercase digits
+static inline int
+cuid_sse2_base36_mask(__m128i const v) {
+  __m128i const digit = _mm_cmplt_epi8(
+      _mm_add_epi8(v, _mm_set1_epi8(0x80 - '0')), _mm_set1_epi8(-128 + 10));
+  __m128i const letter = _mm_cmplt_epi8(
+      _mm_add_epi8(v, _mm_set1_epi8(0x80 - 'a')), _mm_set1_epi8(-128 + 26));
+  return _mm_movemask_epi8(_mm_or_si128(digit, letter));
 }
-#define CUID_READ_COUNTER cuid_read_counter
 
-static inline cuid_counter_t
-cuid_inc_counter(cuid_counter_t c) {
-  c.value++;
-  return c;
+static inline int
+cuid_validate_sse2(char const cuid_str[CUID_STATIC CUID_SIZE]) {
+  __m128i const head = _mm_loadu_si128((__m128i const *)(void const *)cuid_str);
+  __m128i const tail =
+    _mm_loadu_si128((__m128i const *)(void const *)&cuid_str[CUID_SIZE - 16]);
+  // The last byte of `tail` is the '\0', not checked by the mask
+  return cuid_str[0] == 'c' && cuid_str[CUID_SIZE - 1] == '\0'
+    && cuid_sse2_base36_mask(head) == 0xFFFF
+    && (cuid_sse2_base36_mask(tail) & 0x7FFF) == 0x7FFF;
 }
-#define CUID_INCREASE_COUNTER cuid_inc_counter
 
-#endif // CUID_COUNTER_T
+#elif defined(CUID_SIMD_NEON)
+// Returns 0xFF for each byte of `v` that is a base36 lowercase digit
+static inline uint8x16_t
+cuid_neon_base36_mask(uint8x16_t const v) {
+  return vorrq_u8(vcltq_u8(vsubq_u8(v, vdupq_n_u8('0')), vdupq_n_u8(10)),
+                  vcltq_u8(vsubq_u8(v, vdupq_n_u8('a')), vdupq_n_u8(26)));
+}
+
+static inline int
+cuid_validate_neon(char const cuid_str[CUID_STATIC CUID_SIZE]) {
+  uint8_t const *bytes = (uint8_t const *)cuid_str;
+  uint8x16_t const head = cuid_neon_base36_mask(vld1q_u8(bytes));
+  // Set the mask of the '\0' byte, it is checked separately
+  uint8x16_t const tail = vsetq_lane_u8(0xFF,
+      cuid_neon_base36_mask(vld1q_u8(&bytes[CUID_SIZE - 16])), 15);
+  return cuid_str[0] == 'c' && cuid_str[CUID_SIZE - 1] == '\0'
+    && vminvq_u8(vandq_u8(head, tail)) == 0xFF;
+}
+#endif /* CUID_SIMD_X86 */
 
 /*
-** The random number generator is also split in several functions, these follow
+** Runtime CPU dispatch of the kernels that have SIMD versions.
+**
+** There is a `cuid_kernels_t` table of function pointers for each CPU
+** level. The level is selected once, at the first call to `cuid_kernels`,
+** as the best one that the header was compiled for and that the CPU
+** supports, detected with cpuid (`__builtin_cpu_supports`) on x86_64 and
+** with the hwcaps on aarch64 Linux.
+**
+** To force a level, e.g. to benchmark a kernel against its scalar version,
+** define CUID_FORCE_CPU_LEVEL as one of the CUID_CPU_* levels, set the
+** CUID_CPU_LEVEL environment variable to the name of the level ("scalar",
+** "sse2", "avx2" or "neon"), or call `cuid_set_cpu_level`. A level that the
+** CPU does not support is ignored and the best level is used instead.
+** Define CUID_CPU_LEVEL_ENV to read the level from another variable.
+*/
+#define CUID_CPU_SCALAR (0)
+#define CUID_CPU_SSE2 (1)
+#define CUID_CPU_AVX2 (2)
+#define CUID_CPU_NEON (3)
+#define CUID_CPU_LEVELS (4)
+#ifndef CUID_CPU_LEVEL_ENV
+#define CUID_CPU_LEVEL_ENV "CUID_CPU_LEVEL"
+#endif /* CUID_CPU_LEVEL_ENV */
+#include <stdlib.h> // getenv
+#include <string.h> // strcmp
+#if defined(CUID_SIMD_NEON) && defined(__linux__)
+#include <sys/auxv.h> // getauxval, HWCAP_ASIMD
+#endif /* CUID_SIMD_NEON */
+
+typedef struct cuid_kernels_t {
+  void (*cuid_base36_blocks)(uint32_t const *, size_t, char *, size_t);
+  int (*cuid_validate)(char const *);
+} cuid_kernels_t;
+
+// The kernels of each level, the levels not compiled in are scalar
+static cuid_kernels_t const cuid_kernels_by_level[CUID_CPU_LEVELS] = {
+  { cuid_base36_blocks_scalar, cuid_validate_scalar },
+#if defined(CUID_SIMD_X86)
+  { cuid_base36_blocks_sse2, cuid_validate_sse2 },
+  { cuid_base36_blocks_avx2, cuid_validate_sse2 },
+#else
+  { cuid_base36_blocks_scalar, cuid_validate_scalar },
+  { cuid_base36_blocks_scalar, cuid_validate_scalar },
+#endif /* CUID_SIMD_X86 */
+#if defined(CUID_SIMD_NEON)
+  { cuid_base36_blocks_neon, cuid_validate_neon },
+#else
+  { cuid_base36_blocks_scalar, cuid_validate_scalar },
+#endif /* CUID_SIMD_NEON */
+};
+
+static char const *const cuid_cpu_level_names[CUID_CPU_LEVELS] = {
+  "scalar", "sse2", "avx2", "neon"
+};
+
+// The selected level, -1 until the first call to `cuid_kernels`
+#ifdef CUID_THREADS
+static CUID_ATOMIC(int) cuid_cpu_selected = -1;
+#else
+static int cuid_cpu_selected = -1;
+#endif /* CUID_THREADS */
+
+/*
+** Returns 1 if the kernels of the CPU `level` are compiled in and the CPU
+** can run them, 0 otherwise.
+*/
+static inline int
+cuid_cpu_supports(int const level) {
+  if (level == CUID_CPU_SCALAR) {
+    return 1;
+  }
+#if defined(CUID_SIMD_X86)
+  // SSE2 is part of x86_64
+  if (level == CUID_CPU_SSE2) {
+    return 1;
+  }
+  if (level == CUID_CPU_AVX2) {
+    return __builtin_cpu_supports("avx2") != 0;
+  }
+#elif defined(CUID_SIMD_NEON)
+  if (level == CUID_CPU_NEON) {
+#if defined(__linux__) && defined(HWCAP_ASIMD)
+    return (getauxval(AT_HWCAP) & HWCAP_ASIMD) != 0;
+#else
+    return 1;
+#endif /* __linux__ */
+  }
+#endif /* CUID_SIMD_X86 */
+  return 0;
+}
+
+/*
+** Returns the name of a CPU level, or NULL if it is not a level.
+*/
+static inline char const *
+cuid_cpu_level_name(int const level) {
+  if (level < 0 || level >= CUID_CPU_LEVELS) {
+    return 0x0;
+  }
+  return cuid_cpu_level_names[level];
+}
+
+/*
+** Returns the level that `cuid_kernels` starts with: CUID_FORCE_CPU_LEVEL
+** when it is defined, otherwise the level named by the CUID_CPU_LEVEL
+** environment variable. Falls back to the best supported level.
+*/
+static inline int
+cuid_cpu_detect_level(void) {
+  int best = CUID_CPU_LEVELS - 1;
+  while (!cuid_cpu_supports(best)) {
+    best--;
+  }
+#ifdef CUID_FORCE_CPU_LEVEL
+  int const forced = CUID_FORCE_CPU_LEVEL;
+#else
+  int forced = -1;
+  char const *name = getenv(CUID_CPU_LEVEL_ENV);
+  for (int i = 0; name != 0x0 && i < CUID_CPU_LEVELS; ++i) {
+    if (strcmp(name, cuid_cpu_level_names[i]) == 0) {
+      forced = i;
+    }
+  }
+#endif /* CUID_FORCE_CPU_LEVEL */
+  if (forced >= 0 && forced < CUID_CPU_LEVELS && cuid_cpu_supports(forced)) {
+    return forced;
+  }
+  return best;
+}
+
+/*
+** Returns the CPU level of the kernels in use, selecting it on the first
+** call.
+*/
+static inline int
+cuid_cpu_level(void) {
+#ifdef CUID_THREADS
+  int level = atomic_load_explicit(&cuid_cpu_selected, memory_order_relaxed);
+  if (level < 0) {
+    // Racing threads select the same level
+    level = cuid_cpu_detect_level();
+    atomic_store_explicit(&cuid_cpu_selected, level, memory_order_relaxed);
+  }
+#else
+  int level = cuid_cpu_selected;
+  if (level < 0) {
+    level = cuid_cpu_detect_level();
+    cuid_cpu_selected = level;
+  }
+#endif /* CUID_THREADS */
+  return level;
+}
+
+/*
+** Uses the kernels of the CPU `level` from now on.
+** Returns 1 if the level was set, 0 if the CPU does not support it.
+*/
+static inline int
+cuid_set_cpu_level(int const level) {
+  if (level < 0 || level >= CUID_CPU_LEVELS || !cuid_cpu_supports(level)) {
+    return 0;
+  }
+#ifdef CUID_THREADS
+  atomic_store_explicit(&cuid_cpu_selected, level, memory_order_relaxed);
+#else
+  cuid_cpu_selected = level;
+#endif /* CUID_THREADS */
+  return 1;
+}
+
+/*
+** Returns the table of kernels of the selected CPU level.
+*/
+static inline cuid_kernels_t const *
+cuid_kernels(void) {
+  return &cuid_kernels_by_level[cuid_cpu_level()];
+}
+
+static inline void
+cuid_base36_blocks(uint32_t const *values,
+                   size_t const n,
+                   char *out,
+                   size_t const stride) {
+  cuid_kernels()->cuid_base36_blocks(values, n, out, stride);
+}
+
+static inline int
+cuid_validate(char const cuid_str[CUID_STATIC CUID_SIZE]) {
+  return cuid_kernels()->cuid_validate(cuid_str);
+}
+
+/*
+** Validates the `n` cuid strings of the `cuid_strs` array.
+** If `valid` is not NULL then `valid[i]` is set to 1 for each valid cuid and
+** to 0 otherwise.
+** Returns the number of valid cuids.
+*/
+static inline size_t
+cuid_validate_n(char cuid_strs[][CUID_SIZE], size_t n, uint8_t *valid) {
+  size_t count = 0;
+  for (size_t i = 0; i < n; ++i) {
+    int const is_valid = cuid_validate(cuid_strs[i]);
+    if (valid) {
+      valid[i] = (uint8_t)is_valid;
+    }
+    count += (size_t)is_valid;
+  }
+  return count;
+}
+
+/*
+** The numbers of each block of a cuid.
+*/
+typedef struct cuid_parts_t {
+  uint64_t timestamp;
+  uint32_t counter;
+  uint32_t fingerprint;
+  uint32_t random1;
+  uint32_t random2;
+} cuid_parts_t;
+
+/*
+** Validates a cuid string and splits it into the numbers of its blocks.
+** Returns 1 on success, 0 if the string is not a valid cuid (in which case
+** `cuid_parts` is left untouched).
+*/
+static inline int
+cuid_parse(char const cuid_str[CUID_STATIC CUID_SIZE],
+           cuid_parts_t *cuid_parts) {
+  if (!cuid_validate(cuid_str)) {
+    return 0;
+  }
+  cuid_parts->timestamp = cuid_base36_decode_valid(
+    &cuid_str[CUID_TIMESTAMP_OFFSET], CUID_TIMESTAMP_LENGTH);
+  cuid_parts->counter = (uint32_t)cuid_base36_decode_valid(
+    &cuid_str[CUID_COUNTER_OFFSET], CUID_BLOCK_LENGTH);
+  cuid_parts->fingerprint = (uint32_t)cuid_base36_decode_valid(
+    &cuid_str[CUID_FINGERPRINT_OFFSET], CUID_BLOCK_LENGTH);
+  cuid_parts->random1 = (uint32_t)cuid_base36_decode_valid(
+    &cuid_str[CUID_RANDOM1_OFFSET], CUID_BLOCK_LENGTH);
+  cuid_parts->random2 = (uint32_t)cuid_base36_decode_valid(
+    &cuid_str[CUID_RANDOM2_OFFSET], CUID_BLOCK_LENGTH);
+  return 1;
+}
+
+/*-- MARK: Binary cuids ------------------------------------------------------*/
+/*
+** The packed binary form of a cuid, 16 bytes instead of the 24 of the string.
+**
+** The constant 'c' prefix is dropped and each block is stored as a big-endian
+** number: 32 bits for the timestamp (6 base36 digits are less than 2^32) and
+** 24 bits for each of the counter, fingerprint and the two random blocks
+** (4 base36 digits are less than 2^21). A longer CUID_TIMESTAMP_LENGTH takes
+** 40 bits for 7 digits and 48 bits for 8 digits.
+**
+** The blocks keep the order of the string and the base36 digits are sorted
+** in ASCII, so comparing two `cuid_bin_t` with `memcmp` gives the same order
+** as comparing their strings with `strcmp`.
+*/
+#if CUID_TIMESTAMP_LENGTH <= 6
+#define CUID_BIN_TIMESTAMP_SIZE 4
+#else
+#define CUID_BIN_TIMESTAMP_SIZE (CUID_TIMESTAMP_LENGTH - 2)
+#endif /* CUID_TIMESTAMP_LENGTH */
+#define CUID_BIN_BLOCK_SIZE 3
+#define CUID_BIN_SIZE (CUID_BIN_TIMESTAMP_SIZE + 4 * CUID_BIN_BLOCK_SIZE)
+typedef struct cuid_bin_t {
+  uint8_t bytes[CUID_BIN_SIZE];
+} cuid_bin_t;
+
+// Stores the lowest `length` bytes of `value` in big-endian order
+static inline void
+cuid_bin_store(uint8_t *bytes, uint64_t value, size_t length) {
+  while (length > 0) {
+    length--;
+    bytes[length] = (uint8_t)value;
+    value >>= 8;
+  }
+}
+
+// Reads a `length` bytes big-endian number
+static inline uint64_t
+cuid_bin_load(uint8_t const *bytes, size_t length) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < length; i++) {
+    value = (value << 8) | bytes[i];
+  }
+  return value;
+}
+
+/*
+** Packs a cuid string, as produced by `cuid()` or `cuid_gen_value_string`,
+** into its binary form.
+** Returns 1 on success, 0 if the string is not a valid cuid (in which case
+** `cuid_bin` is left untouched).
+*/
+static inline int
+cuid_bin_encode(char const cuid_str[CUID_STATIC CUID_SIZE],
+                cuid_bin_t *cuid_bin) {
+  cuid_parts_t parts = {0, 0, 0, 0, 0};
+  if (!cuid_parse(cuid_str, &parts)) {
+    return 0;
+  }
+  uint8_t *blocks = &cuid_bin->bytes[CUID_BIN_TIMESTAMP_SIZE];
+  cuid_bin_store(cuid_bin->bytes, parts.timestamp, CUID_BIN_TIMESTAMP_SIZE);
+  cuid_bin_store(&blocks[0], parts.counter, CUID_BIN_BLOCK_SIZE);
+  cuid_bin_store(&blocks[3], parts.fingerprint, CUID_BIN_BLOCK_SIZE);
+  cuid_bin_store(&blocks[6], parts.random1, CUID_BIN_BLOCK_SIZE);
+  cuid_bin_store(&blocks[9], parts.random2, CUID_BIN_BLOCK_SIZE);
+  return 1;
+}
+
+/*
+** Unpacks a binary cuid into its string form.
+** The string is '\0' terminated, its length is returned.
+*/
+static inline size_t
+cuid_bin_decode(cuid_bin_t const *cuid_bin,
+                char cuid_result[CUID_STATIC CUID_SIZE]) {
+  cuid_result[0] = 'c';
+  cuid_base36_timestamp(
+    cuid_bin_load(cuid_bin->bytes, CUID_BIN_TIMESTAMP_SIZE),
+    &cuid_result[CUID_TIMESTAMP_OFFSET]);
+  for (size_t i = 0; i < 4; i++) {
+    uint8_t const *block =
+      &cuid_bin->bytes[CUID_BIN_TIMESTAMP_SIZE + i * CUID_BIN_BLOCK_SIZE];
+    cuid_base36_block((uint32_t)cuid_bin_load(block, CUID_BIN_BLOCK_SIZE),
+                      &cuid_result[CUID_COUNTER_OFFSET
+                                   + i * CUID_BLOCK_LENGTH]);
+  }
+  cuid_result[CUID_SIZE - 1] = '\0';
+  return CUID_SIZE - 1;
+}
+
+/*-- MARK: Hashing and comparison --------------------------------------------*/
+/*
+** Hashing and ordering of cuids as fixed-width keys, for the string and the
+** binary forms.
+**
+** A key of `size` bytes (8 or more) is read as 64 bit words: at the offsets
+** 0, 8, 16, ... and a last word at `size - 8`, that overlaps the previous one
+** when `size` is not a multiple of 8. The sizes are constants, so each loop
+** is unrolled into a few loads (3 for a 24 chars cuid, 2 for a 16 bytes
+** binary cuid).
+**
+** The words are compared as big-endian numbers, which is the order of
+** `memcmp`, so the order is the same as `strcmp` on the strings.
+*/
+#include <string.h> // memcpy
+
+// Reads the 8 bytes at `bytes` in the order of the machine
+static inline uint64_t
+cuid_load64(unsigned char const *bytes) {
+  uint64_t word = 0;
+  memcpy(&word, bytes, sizeof word);
+  return word;
+}
+
+// Reads the 8 bytes at `bytes` as a big-endian number
+static inline uint64_t
+cuid_load64_be(unsigned char const *bytes) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  return __builtin_bswap64(cuid_load64(bytes));
+#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  return cuid_load64(bytes);
+#else
+  return cuid_bin_load(bytes, 8);
+#endif
+}
+
+// The offset of the word `i` of a key of `size` bytes
+static inline size_t
+cuid_word_offset(size_t const i, size_t const size) {
+  return i * 8 + 8 > size ? size - 8 : i * 8;
+}
+
+/*
+** Returns the hash of the `size` bytes of `key`: each word is mixed into the
+** hash by a multiply, then the murmur3 64 bit finalizer spreads the bits.
+*/
+static inline uint64_t
+cuid_hash_bytes(unsigned char const *key, size_t const size) {
+  uint64_t hash = 0x9E3779B97F4A7C15ULL ^ size;
+  for (size_t i = 0; i * 8 < size; ++i) {
+    hash = (hash ^ cuid_load64(&key[cuid_word_offset(i, size)]))
+      * 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 31;
+  }
+  hash ^= hash >> 33;
+  hash *= 0xFF51AFD7ED558CCDULL;
+  hash ^= hash >> 33;
+  hash *= 0xC4CEB9FE1A85EC53ULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+// Returns 1 if the `size` bytes of `a` and `b` are the same, 0 otherwise
+static inline int
+cuid_equal_bytes(unsigned char const *a, unsigned char const *b,
+                 size_t const size) {
+  uint64_t difference = 0;
+  for (size_t i = 0; i * 8 < size; ++i) {
+    size_t const offset = cuid_word_offset(i, size);
+    difference |= cuid_load64(&a[offset]) ^ cuid_load64(&b[offset]);
+  }
+  return difference == 0;
+}
+
+/*
+** Compares the `size` bytes of `a` and `b` as `memcmp` does.
+** Returns -1, 0 or 1 if `a` is less, equal or greater than `b`.
+*/
+static inline int
+cuid_compare_bytes(unsigned char const *a, unsigned char const *b,
+                   size_t const size) {
+  for (size_t i = 0; i * 8 < size; ++i) {
+    size_t const offset = cuid_word_offset(i, size);
+    uint64_t const word_a = cuid_load64_be(&a[offset]);
+    uint64_t const word_b = cuid_load64_be(&b[offset]);
+    if (word_a != word_b) {
+      return word_a < word_b ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+/*
+** The hash, equality and order of cuid strings. All of the `CUID_SIZE` bytes
+** are read, the order is the order of `strcmp`.
+*/
+static inline uint64_t
+cuid_hash(char const cuid_str[CUID_STATIC CUID_SIZE]) {
+  return cuid_hash_bytes((unsigned char const *)cuid_str, CUID_SIZE);
+}
+
+static inline int
+cuid_equal(char const a[CUID_STATIC CUID_SIZE],
+           char const b[CUID_STATIC CUID_SIZE]) {
+  return cuid_equal_bytes((unsigned char const *)a, (unsigned char const *)b,
+                          CUID_SIZE);
+}
+
+static inline int
+cuid_compare(char const a[CUID_STATIC CUID_SIZE],
+             char const b[CUID_STATIC CUID_SIZE]) {
+  return cuid_compare_bytes((unsigned char const *)a,
+                            (unsigned char const *)b, CUID_SIZE);
+}
+
+/*
+** The hash, equality and order of binary cuids, the order is the order of
+** their strings.
+*/
+static inline uint64_t
+cuid_bin_hash(cuid_bin_t const *cuid_bin) {
+  return cuid_hash_bytes(cuid_bin->bytes, CUID_BIN_SIZE);
+}
+
+static inline int
+cuid_bin_equal(cuid_bin_t const *a, cuid_bin_t const *b) {
+  return cuid_equal_bytes(a->bytes, b->bytes, CUID_BIN_SIZE);
+}
+
+static inline int
+cuid_bin_compare(cuid_bin_t const *a, cuid_bin_t const *b) {
+  return cuid_compare_bytes(a->bytes, b->bytes, CUID_BIN_SIZE);
+}
+
+#ifdef CUID_PURE
+/*
+** The cuid() pure API
+**
+** This is an optional API that provides a set of
+** functions that depend only on their arguments to create a cuid string. 
+** This can be useful if you want to partially build your cuid's or integrate
+** with some other language cuid library through its FFI.
+**
+** All functions are declared as static inline to prevent copies.
+** To use this library please set -DCUID_PURE in your compiler arguments
+** or define the CUID_PURE macro in the code that includes this .h file.
+**
+*/
+
+/*
+** The counter is split in several functions, most of them are pure and
+** should have no side-effects:
+**
+** - CUID_CREATE_COUNTER: creates the CUID_COUNTER_T data type
+**   * with type: `COUNTER_T CREATE_COUNTER(void);`
+** - CUID_INIT_COUNTER: initializes the created CUID_COUNTER_T with the startup
+**   value(s)
+**   * with type: `CUID_COUNTER_T CUID_INIT_COUNTER(CUID_COUNTER_T);`
+** - CUID_READ_COUNTER: returns the counter value (unsigned int)
+**   * with type: `unsigned CUID_READ_COUNTER(CUID_COUNTER_T);`
+** - CUID_INCREASE_COUNTER: increases counter value 
+**   * with type: `CUID_COUNTER_T CUID_INCREASE_COUNTER(CUID_COUNTER_T);`
+**
+** In order to override the cuid counter with a specific implementation
+** please define them all, as well as the CUID_COUNTER_T type, be sure that
+** they can be called during startup as:
+**
+**   CUID_COUNTER_T c = CUID_INIT_COUNTER(CUID_CREATE_COUNTER())
+**
+** And then at each call as:
+**
+** CUID_COUNTER_T next_counter = CUID_INCREASE_COUNTER(c)
+** unsigned value = CUID_READ_COUNTER(next_counter)
+**
+** A default implementation is provided which increments a simple variable as
+** `c++;` // this is not subliminal
+** and starts again at 0 when it reaches CUID_COUNTER_MAX, what fits in the
+** counter block, so that it never wraps at the end of the unsigned instead.
+**
+** Each of the INIT, READ and INCREASE functions also has a `_PTR` variant
+** that works on a `CUID_COUNTER_T *` in place (and `CUID_COUNTER_T const *`
+** for READ). These are used by the in-place `cuid_*_inplace` functions.
+** When overriding the counter it is enough to define the value variants, the
+** `_PTR` ones default to wrappers around them.
+**
+*/
+#ifndef CUID_COUNTER_T
+typedef struct cuid_counter_t {
+  unsigned value;
+} cuid_counter_t;
+#define CUID_COUNTER_T cuid_counter_t
+
+static inline cuid_counter_t cuid_create_counter(void) {
+  cuid_counter_t const counter = {0U};
+  return counter;
+}
+#define CUID_CREATE_COUNTER cuid_create_counter
+
+static inline void
+cuid_init_counter_ptr(cuid_counter_t *c) {
+  c->value = 0U;
+}
+#define CUID_INIT_COUNTER_PTR cuid_init_counter_ptr
+
+static inline cuid_counter_t
+cuid_init_counter(cuid_counter_t c) {
+  cuid_init_counter_ptr(&c);
+  return c;
+}
+
+static inline void
+cuid_reseed_counter_ptr(cuid_counter_t *c, uint64_t const seed) {
+  c->value = (unsigned)(seed % CUID_COUNTER_MAX);
+}
+#define CUID_RESEED_COUNTER_PTR cuid_reseed_counter_ptr
+
+static inline void
+cuid_restore_counter_ptr(cuid_counter_t *c, uint64_t const value) {
+  c->value = (unsigned)(value % CUID_COUNTER_MAX);
+}
+#define CUID_RESTORE_COUNTER_PTR cuid_restore_counter_ptr
+
+static inline void
+cuid_skip_counter_ptr(cuid_counter_t *c, uint64_t const n) {
+  c->value = (unsigned)((c->value % CUID_COUNTER_MAX + n % CUID_COUNTER_MAX)
+                        % CUID_COUNTER_MAX);
+}
+#define CUID_SKIP_COUNTER_PTR cuid_skip_counter_ptr
+#define CUID_INIT_COUNTER cuid_init_counter
+
+static inline unsigned
+cuid_read_counter_ptr(cuid_counter_t const *c) {
+  return c->value;
+}
+#define CUID_READ_COUNTER_PTR cuid_read_counter_ptr
+
+static inline unsigned
+cuid_read_counter(cuid_counter_t const c) {
+  return cuid_read_counter_ptr(&c);
+}
+#define CUID_READ_COUNTER cuid_read_counter
+
+static inline void
+cuid_inc_counter_ptr(cuid_counter_t *c) {
+  c->value = c->value + 1U < CUID_COUNTER_MAX ? c->value + 1U : 0U;
+}
+#define CUID_INCREASE_COUNTER_PTR cuid_inc_counter_ptr
+
+static inline cuid_counter_t
+cuid_inc_counter(cuid_counter_t c) {
+  cuid_inc_counter_ptr(&c);
+  return c;
+}
+#define CUID_INCREASE_COUNTER cuid_inc_counter
+
+#endif // CUID_COUNTER_T
+
+/*
+** The random number generator is also split in several functions, these follow
 ** the same logic and approach as the COUNTER_T above.
 ** 
 ** After creation the functions are intended to be pure and should have
@@ -321,297 +1579,2850 @@ cuid_inc_counter(cuid_counter_t c) {
 ** CUID_RANDOM_T next_random = CUID_NEXT_RANDOM(r)
 ** uint32_t value = CUID_READ_RANDOM(next_random)
 **
+** As with the counter, the CREATE, INIT, READ and NEXT functions have `_PTR`
+** variants that work in place on a `CUID_RANDOM_T *`:
+**
+**   * `void CUID_CREATE_RANDOM_PTR(CUID_RANDOM_T *);`
+**   * `void CUID_INIT_RANDOM_PTR(CUID_RANDOM_T *);`
+**   * `uint32_t CUID_READ_RANDOM_PTR(CUID_RANDOM_T const *);`
+**   * `void CUID_NEXT_RANDOM_PTR(CUID_RANDOM_T *);`
+**
+** If they are not defined they default to wrappers around the value variants.
+**
+** The batch functions take their random numbers in blocks from
+** CUID_FILL_RANDOM_PTR, which writes the numbers of the next `n` calls to
+** CUID_NEXT_RANDOM_PTR + CUID_READ_RANDOM_PTR into `out`, leaving the state
+** as those calls would. It defaults to a loop of these calls:
+**
+**   * `void CUID_FILL_RANDOM_PTR(CUID_RANDOM_T *, uint32_t *out, size_t n);`
+**
 ** A default implementation is provided which uses MWC[0] with stdlib.h rand().
 **
 ** A random number generator must return a uint32_t.
 **
 ** [0] - https://github.com/HugoDaniel/mwc
 */
-#ifndef CUID_RANDOM_T
-
-#ifndef MWC_SYSTEM_RAND32
-#include <stdlib.h> // arc4random()
-#define MWC_SYSTEM_RAND32 arc4random
-#endif /* MWC_SYSTEM_RAND32 */
+/*
+** Returns the next number of the SplitMix64 sequence of `state`, used to
+** spread a few bytes of entropy over the state of the generators when they
+** are reseeded (see `cuid_reseed_inplace`).
+*/
+static inline uint64_t
+cuid_splitmix64(uint64_t *state) {
+  uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
 
-#define MWC_CYCLE 4096         // as Marsaglia recommends
-#define MWC_C_MAX 809430660    // as Marsaglia recommends
+/*
+** A compact random number generator, PCG32[1], with 24 bytes of state.
+**
+** Define the macro CUID_RANDOM_PCG32 to use it as the CUID_RANDOM_T instead
+** of the default MWC, which keeps 32KB of state per generator and calls
+** MWC_SYSTEM_RAND32 4097 times when created (see CUID_MWC_SEEDED). PCG32 is
+** created from four MWC_SYSTEM_RAND32 numbers.
+**
+** It also defines CUID_PEEK_RANDOM_PTR, which returns the number that the
+** next call to CUID_NEXT_RANDOM_PTR would produce without changing the
+** state:
+**
+**   * `uint32_t CUID_PEEK_RANDOM_PTR(CUID_RANDOM_T const *);`
+**
+** When a random implementation defines CUID_PEEK_RANDOM_PTR the `cuid_t`
+** keeps a single generator, which is advanced twice per cuid and provides
+** the numbers for both random blocks.
+**
+** [1] - https://www.pcg-random.org
+*/
+typedef struct cuid_pcg32_t {
+  uint64_t pcg_state;
+  // The stream increment, always odd
+  uint64_t pcg_inc;
+  // The state at creation, to allow `cuid_pcg32_init` to reset it
+  uint64_t pcg_initial_state;
+} cuid_pcg32_t;
 
-typedef struct mwc_random_t {
-	uint32_t mwc_q[MWC_CYCLE];
-	uint32_t mwc_carry;
-	unsigned mwc_current_cycle;
-	uint32_t mwc_initial_carry;
-	uint32_t mwc_initial_q[MWC_CYCLE];
-} mwc_random_t;
+#define CUID_PCG32_MULTIPLIER 6364136223846793005ULL
 
-#define CUID_RANDOM_T mwc_random_t
+/*
+** Returns the PCG32 XSH RR output for a state.
+*/
+static inline uint32_t
+cuid_pcg32_output(uint64_t const state) {
+  uint32_t const xorshifted = (uint32_t)(((state >> 18U) ^ state) >> 27U);
+  uint32_t const rot = (uint32_t)(state >> 59U);
+  return (xorshifted >> rot) | (xorshifted << ((32U - rot) & 31U));
+}
+
+static inline void
+cuid_pcg32_create_ptr(cuid_pcg32_t *r) {
+  uint64_t const seed = (uint64_t)MWC_SYSTEM_RAND32() << 32
+                      | MWC_SYSTEM_RAND32();
+  uint64_t const stream = (uint64_t)MWC_SYSTEM_RAND32() << 32
+                        | MWC_SYSTEM_RAND32();
+  // As in the PCG32 reference seeding
+  r->pcg_inc = (stream << 1U) | 1U;
+  r->pcg_state = (r->pcg_inc + seed) * CUID_PCG32_MULTIPLIER + r->pcg_inc;
+  r->pcg_initial_state = r->pcg_state;
+}
+
+static inline cuid_pcg32_t
+cuid_pcg32_create(void) {
+  cuid_pcg32_t r;
+  cuid_pcg32_create_ptr(&r);
+  return r;
+}
+
+static inline void
+cuid_pcg32_init_ptr(cuid_pcg32_t *r) {
+  r->pcg_state = r->pcg_initial_state;
+}
+
+static inline cuid_pcg32_t
+cuid_pcg32_init(cuid_pcg32_t r) {
+  cuid_pcg32_init_ptr(&r);
+  return r;
+}
+
+static inline uint32_t
+cuid_pcg32_read_ptr(cuid_pcg32_t const *r) {
+  return cuid_pcg32_output(r->pcg_state);
+}
+
+static inline uint32_t
+cuid_pcg32_read(cuid_pcg32_t const r) {
+  return cuid_pcg32_read_ptr(&r);
+}
+
+static inline uint32_t
+cuid_pcg32_peek_ptr(cuid_pcg32_t const *r) {
+  return cuid_pcg32_output(r->pcg_state * CUID_PCG32_MULTIPLIER + r->pcg_inc);
+}
+
+static inline void
+cuid_pcg32_next_ptr(cuid_pcg32_t *r) {
+  r->pcg_state = r->pcg_state * CUID_PCG32_MULTIPLIER + r->pcg_inc;
+}
+
+static inline cuid_pcg32_t
+cuid_pcg32_next(cuid_pcg32_t r) {
+  cuid_pcg32_next_ptr(&r);
+  return r;
+}
+
+/*
+** Moves the state pointed by `r`, and its initial state, to another point of
+** another stream chosen by `seed`.
+*/
+static inline void
+cuid_pcg32_reseed_ptr(cuid_pcg32_t *r, uint64_t seed) {
+  uint64_t const state = cuid_splitmix64(&seed);
+  r->pcg_state ^= state;
+  r->pcg_initial_state ^= state;
+  r->pcg_inc = (r->pcg_inc ^ (cuid_splitmix64(&seed) << 1U)) | 1U;
+}
+
+/*
+** Advances the state pointed by `r` by `n` numbers in O(log n) steps, as in
+** the PCG32 reference `pcg32_advance`: the `n` LCG steps are folded into a
+** single multiply and add, built by squaring.
+*/
+static inline void
+cuid_pcg32_skip_ptr(cuid_pcg32_t *r, uint64_t n) {
+  uint64_t step_multiplier = CUID_PCG32_MULTIPLIER;
+  uint64_t step_increment = r->pcg_inc;
+  uint64_t multiplier = 1;
+  uint64_t increment = 0;
+  while (n > 0) {
+    if (n & 1U) {
+      multiplier *= step_multiplier;
+      increment = increment * step_multiplier + step_increment;
+    }
+    step_increment = (step_multiplier + 1) * step_increment;
+    step_multiplier *= step_multiplier;
+    n >>= 1U;
+  }
+  r->pcg_state = multiplier * r->pcg_state + increment;
+}
+
+/*
+** Writes the next `n` numbers of the state pointed by `r` into `out`, and
+** advances it by `n`.
+**
+** Each number needs the state before it, so the numbers are made by 4
+** interleaved lanes: lane `k` starts `k + 1` steps ahead and moves 4 steps
+** at a time with a single multiply and add (as in `cuid_pcg32_skip_ptr`).
+** The 4 lanes have no dependency among them and run in parallel.
+*/
+static inline void
+cuid_pcg32_fill_ptr(cuid_pcg32_t *r, uint32_t *out, size_t const n) {
+  uint64_t const multiplier = CUID_PCG32_MULTIPLIER;
+  uint64_t const increment = r->pcg_inc;
+  uint64_t state = r->pcg_state;
+  size_t i = 0;
+  if (n >= 4) {
+    uint64_t const multiplier4 = multiplier * multiplier
+                                 * multiplier * multiplier;
+    uint64_t const increment4 = (multiplier * multiplier * multiplier
+                                 + multiplier * multiplier
+                                 + multiplier + 1) * increment;
+    uint64_t lanes[4];
+    lanes[0] = state * multiplier + increment;
+    for (size_t k = 1; k < 4; ++k) {
+      lanes[k] = lanes[k - 1] * multiplier + increment;
+    }
+    for (; i + 4 <= n; i += 4) {
+      for (size_t k = 0; k < 4; ++k) {
+        out[i + k] = cuid_pcg32_output(lanes[k]);
+      }
+      state = lanes[3];
+      for (size_t k = 0; k < 4; ++k) {
+        lanes[k] = lanes[k] * multiplier4 + increment4;
+      }
+    }
+  }
+  for (; i < n; ++i) {
+    state = state * multiplier + increment;
+    out[i] = cuid_pcg32_output(state);
+  }
+  r->pcg_state = state;
+}
+
+/*
+** The snapshot of a PCG32 state is its three numbers, it is restored in
+** constant time.
+*/
+#define CUID_PCG32_SNAPSHOT_WORDS 3
+
+static inline void
+cuid_pcg32_snapshot_ptr(cuid_pcg32_t const *r,
+                        uint64_t words[CUID_PCG32_SNAPSHOT_WORDS]) {
+  words[0] = r->pcg_state;
+  words[1] = r->pcg_inc;
+  words[2] = r->pcg_initial_state;
+}
+
+static inline int
+cuid_pcg32_restore_ptr(cuid_pcg32_t *r,
+                       uint64_t const words[CUID_PCG32_SNAPSHOT_WORDS]) {
+  if ((words[1] & 1U) == 0) {
+    // The increment of a PCG32 is always odd
+    return 0;
+  }
+  r->pcg_state = words[0];
+  r->pcg_inc = words[1];
+  r->pcg_initial_state = words[2];
+  return 1;
+}
+
+#if defined(CUID_RANDOM_PCG32) && !defined(CUID_RANDOM_T)
+#define CUID_RANDOM_T cuid_pcg32_t
+#define CUID_CREATE_RANDOM cuid_pcg32_create
+#define CUID_CREATE_RANDOM_PTR cuid_pcg32_create_ptr
+#define CUID_INIT_RANDOM cuid_pcg32_init
+#define CUID_INIT_RANDOM_PTR cuid_pcg32_init_ptr
+#define CUID_READ_RANDOM cuid_pcg32_read
+#define CUID_READ_RANDOM_PTR cuid_pcg32_read_ptr
+#define CUID_NEXT_RANDOM cuid_pcg32_next
+#define CUID_NEXT_RANDOM_PTR cuid_pcg32_next_ptr
+#define CUID_PEEK_RANDOM_PTR cuid_pcg32_peek_ptr
+#define CUID_RESEED_RANDOM_PTR cuid_pcg32_reseed_ptr
+#define CUID_SNAPSHOT_RANDOM_PTR cuid_pcg32_snapshot_ptr
+#define CUID_RESTORE_RANDOM_PTR cuid_pcg32_restore_ptr
+#define CUID_SKIP_RANDOM_PTR cuid_pcg32_skip_ptr
+#define CUID_FILL_RANDOM_PTR cuid_pcg32_fill_ptr
+#define CUID_RANDOM_SNAPSHOT_WORDS CUID_PCG32_SNAPSHOT_WORDS
+#endif /* CUID_RANDOM_PCG32 */
+
+#ifndef CUID_RANDOM_T
+
+#define MWC_CYCLE 4096         // as Marsaglia recommends
+#define MWC_C_MAX 809430660    // as Marsaglia recommends
+
+typedef struct mwc_random_t {
+	uint32_t mwc_q[MWC_CYCLE];
+	uint32_t mwc_carry;
+	unsigned mwc_current_cycle;
+#ifndef CUID_MWC_SEEDED
+	uint32_t mwc_initial_carry;
+	uint32_t mwc_initial_q[MWC_CYCLE];
+#else
+	// The seed that the lag table and the carry were made from
+	uint64_t mwc_seed;
+	// The numbers generated since seeding, see `mwc_snapshot_ptr`
+	uint64_t mwc_position;
+#endif /* CUID_MWC_SEEDED */
+} mwc_random_t;
+
+#define CUID_RANDOM_T mwc_random_t
+
+/*
+** By default the lag table and the carry are filled by the defined
+** MWC_SYSTEM_RAND32 system random, and a copy of them is kept for
+** `mwc_init()`: the system numbers cannot be made again, so the copy is the
+** price of resetting a generator that has the full system entropy, and its
+** snapshot holds both tables (see `mwc_snapshot_ptr`).
+**
+** Define the macro CUID_MWC_SEEDED to fill them from a 64 bit seed instead,
+** see `mwc_seed_ptr`: this calls MWC_SYSTEM_RAND32 twice instead of
+** MWC_CYCLE + 1 times and keeps the seed and the number of random numbers
+** generated since seeding in place of the copy. This halves the state and
+** makes the snapshot compact, but the random numbers then only have 64 bits
+** of system entropy.
+*/
+#ifndef CUID_MWC_SEEDED
+/*
+** Internal function that creates a carry that is guaranteed to be < MWC_C_MAX.
+** This function uses the defined MWC_SYSTEM_RAND32 system random.
+*/
+static inline uint32_t mwc_initial_c(void) {
+  uint32_t mwc_initial_carry = 0;
+
+  do {
+		mwc_initial_carry = MWC_SYSTEM_RAND32();
+  } while (mwc_initial_carry >= MWC_C_MAX);
+
+  return mwc_initial_carry;
+}
+
+/*
+** Creates a new mwc random state in place.
+** Keeps a copy of the initial state to allow `mwc_init()` to
+** be able to reset it to the same initial state, allowing for the 
+** random numbers generation sequence to be replicated again if needed.
+*/
+static inline void
+mwc_create_ptr(mwc_random_t *mwc_state) {
+  uint32_t mwc_c = mwc_initial_c();
+  mwc_state->mwc_initial_carry = mwc_c;
+  mwc_state->mwc_carry = mwc_c;
+  mwc_state->mwc_current_cycle = MWC_CYCLE -1;
+
+ 	for (size_t i = 0; i < MWC_CYCLE; i++) {
+    mwc_state->mwc_q[i] = MWC_SYSTEM_RAND32();
+    mwc_state->mwc_initial_q[i] = mwc_state->mwc_q[i];
+  }
+}
+#else
+/*
+** Seeds the state pointed by `r` from a 64 bit `seed`: the lag table and the
+** carry (< MWC_C_MAX) are the numbers of a SplitMix64 sequence started at
+** the seed. The same seed always makes the same random numbers sequence.
+*/
+static inline void
+mwc_seed_ptr(mwc_random_t *r, uint64_t const seed) {
+  uint64_t sequence = seed;
+  r->mwc_seed = seed;
+  r->mwc_position = 0;
+  r->mwc_current_cycle = MWC_CYCLE - 1;
+  for (size_t i = 0; i < MWC_CYCLE; i += 2) {
+    uint64_t const mix = cuid_splitmix64(&sequence);
+    r->mwc_q[i] = (uint32_t)mix;
+    r->mwc_q[i + 1] = (uint32_t)(mix >> 32);
+  }
+  r->mwc_carry = (uint32_t)(cuid_splitmix64(&sequence) % MWC_C_MAX);
+}
+
+/*
+** Creates a new mwc random state in place, seeded with 64 bits from the
+** defined MWC_SYSTEM_RAND32 system random.
+** The seed is kept to allow `mwc_init()` to reset the state to the start of
+** its sequence.
+*/
+static inline void
+mwc_create_ptr(mwc_random_t *mwc_state) {
+  mwc_seed_ptr(mwc_state,
+               (uint64_t)MWC_SYSTEM_RAND32() << 32 | MWC_SYSTEM_RAND32());
+}
+#endif /* CUID_MWC_SEEDED */
+
+#define CUID_CREATE_RANDOM_PTR mwc_create_ptr
+
+/*
+** Creates a new mwc random state. 
+** This returns the state by value, prefer `mwc_create_ptr` to avoid copying
+** the state around.
+*/
+static inline mwc_random_t
+mwc_create() {
+  mwc_random_t mwc_state;
+  mwc_create_ptr(&mwc_state);
+  return mwc_state;
+}
+
+#define CUID_CREATE_RANDOM mwc_create
+
+/*
+** Resets the state pointed by `r` to its initial state.
+*/
+static inline void
+mwc_init_ptr(mwc_random_t *r) {
+#ifndef CUID_MWC_SEEDED
+  r->mwc_carry = r->mwc_initial_carry;
+  r->mwc_current_cycle = MWC_CYCLE -1;
+
+ 	for (size_t i = 0; i < MWC_CYCLE; i++) {
+    r->mwc_q[i] = r->mwc_initial_q[i];
+  }
+#else
+  mwc_seed_ptr(r, r->mwc_seed);
+#endif /* CUID_MWC_SEEDED */
+}
+
+#define CUID_INIT_RANDOM_PTR mwc_init_ptr
+
+/*
+** Resets to the initial state.
+*/
+static inline mwc_random_t
+mwc_init(mwc_random_t r) {
+  mwc_init_ptr(&r);
+  return r;
+}
+
+#define CUID_INIT_RANDOM mwc_init
+
+/*
+** Returns the random value for the mwc_random_t state pointed by `state`.
+** Like `mwc_read_random` this does not change the state.
+*/
+static inline uint32_t
+mwc_read_random_ptr(mwc_random_t const *state) {
+  return state->mwc_q[state->mwc_current_cycle];
+}
+
+#define CUID_READ_RANDOM_PTR mwc_read_random_ptr
+
+/*
+** Returns the random value for the supplied mwc_random_t state.
+** This is a pure function, it always returns the same value for the
+** same input argument.
+**
+** To generate a new random number call `state = mwc_next_random(state)` before
+** calling this method.
+*/
+static inline uint32_t
+mwc_read_random(mwc_random_t const state) {
+  return mwc_read_random_ptr(&state);
+}
+
+#define CUID_READ_RANDOM mwc_read_random
+
+/*
+** Advances the state pointed by `state` to the next random number.
+** 
+** To retrieve the random number created, call `mwc_read_random_ptr(state)`
+** after this method.
+*/
+static inline void
+mwc_next_random_ptr(mwc_random_t *state) {
+  uint64_t const a = 18782;	// as Marsaglia recommends
+	uint32_t const m = 0xfffffffe;	// as Marsaglia recommends
+	uint64_t t;
+	uint32_t x;
+
+	state->mwc_current_cycle = (state->mwc_current_cycle + 1) & (MWC_CYCLE - 1);
+	t = a * state->mwc_q[state->mwc_current_cycle] + state->mwc_carry;
+	/* Let c = t / 0xffffffff, x = t mod 0xffffffff */
+	state->mwc_carry = (uint32_t)(t >> 32);
+	x = (uint32_t)t + state->mwc_carry;
+	if (x < state->mwc_carry) {
+		x++;
+		state->mwc_carry++;
+	}
+
+  state->mwc_q[state->mwc_current_cycle] = m - x;
+#ifdef CUID_MWC_SEEDED
+  state->mwc_position += 1;
+#endif /* CUID_MWC_SEEDED */
+}
+
+#define CUID_NEXT_RANDOM_PTR mwc_next_random_ptr
+
+/*
+** This function creates a new random state for the next random number.
+** 
+** To retrieve the random number created, call `mwc_read_random(state)` after
+** this method.
+*/
+static inline mwc_random_t
+mwc_next_random(mwc_random_t state) {
+  mwc_next_random_ptr(&state);
+  return state;
+}
+
+/*
+** Writes the next `n` random numbers of the state pointed by `state` into
+** `out`, the same numbers as `n` calls to `mwc_next_random_ptr` followed by
+** `mwc_read_random_ptr`.
+**
+** Each number needs the carry of the previous one, so this is still one
+** number per step, but the carry and the position in the lag table are
+** kept in registers and the carry correction is branchless.
+*/
+static inline void
+mwc_fill_ptr(mwc_random_t *state, uint32_t *out, size_t const n) {
+  uint64_t const a = 18782;	// as Marsaglia recommends
+  uint32_t const m = 0xfffffffe;	// as Marsaglia recommends
+  uint32_t carry = state->mwc_carry;
+  unsigned cycle = state->mwc_current_cycle;
+  for (size_t i = 0; i < n; ++i) {
+    cycle = (cycle + 1) & (MWC_CYCLE - 1);
+    uint64_t const t = a * state->mwc_q[cycle] + carry;
+    carry = (uint32_t)(t >> 32);
+    uint32_t x = (uint32_t)t + carry;
+    uint32_t const wrapped = x < carry;
+    x += wrapped;
+    carry += wrapped;
+    state->mwc_q[cycle] = m - x;
+    out[i] = m - x;
+  }
+  state->mwc_carry = carry;
+  state->mwc_current_cycle = cycle;
+#ifdef CUID_MWC_SEEDED
+  state->mwc_position += n;
+#endif /* CUID_MWC_SEEDED */
+}
+
+#define CUID_FILL_RANDOM_PTR mwc_fill_ptr
+
+#define CUID_NEXT_RANDOM mwc_next_random
+
+#ifdef CUID_MWC_SEEDED
+/*
+** Reseeds the state pointed by `r` with its seed mixed with `seed`, without
+** calling MWC_SYSTEM_RAND32.
+*/
+static inline void
+mwc_reseed_ptr(mwc_random_t *r, uint64_t const seed) {
+  mwc_seed_ptr(r, r->mwc_seed ^ seed);
+}
+#else
+/*
+** Reseeds the state pointed by `r`, and its initial state, by mixing the
+** numbers of a SplitMix64 sequence started at `seed` into its lag table.
+** This is much cheaper than `mwc_create_ptr`, that calls MWC_SYSTEM_RAND32
+** for each of the MWC_CYCLE numbers.
+*/
+static inline void
+mwc_reseed_ptr(mwc_random_t *r, uint64_t seed) {
+  for (size_t i = 0; i < MWC_CYCLE; i += 2) {
+    uint64_t const mix = cuid_splitmix64(&seed);
+    r->mwc_q[i] ^= (uint32_t)mix;
+    r->mwc_q[i + 1] ^= (uint32_t)(mix >> 32);
+    r->mwc_initial_q[i] ^= (uint32_t)mix;
+    r->mwc_initial_q[i + 1] ^= (uint32_t)(mix >> 32);
+  }
+  r->mwc_carry = (uint32_t)(cuid_splitmix64(&seed) % MWC_C_MAX);
+  r->mwc_initial_carry = r->mwc_carry;
+}
+#endif /* CUID_MWC_SEEDED */
+
+#define CUID_RESEED_RANDOM_PTR mwc_reseed_ptr
+
+/*
+** Advances the state pointed by `r` by `n` numbers, in O(n). A MWC with a
+** lag of MWC_CYCLE has no cheap jump ahead, the numbers are generated one by
+** one; PCG32 (CUID_RANDOM_PCG32) jumps ahead in O(log n).
+*/
+static inline void
+mwc_skip_ptr(mwc_random_t *r, uint64_t const n) {
+  for (uint64_t i = 0; i < n; ++i) {
+    mwc_next_random_ptr(r);
+  }
+}
+
+#define CUID_SKIP_RANDOM_PTR mwc_skip_ptr
+
+#ifdef CUID_MWC_SEEDED
+/*
+** The snapshot of a seeded mwc random state is compact, its seed and the
+** number of random numbers generated since seeding. Restoring it seeds the
+** state again and generates that many numbers, so it takes O(position).
+*/
+#define MWC_SNAPSHOT_WORDS 2
+
+static inline void
+mwc_snapshot_ptr(mwc_random_t const *r, uint64_t words[MWC_SNAPSHOT_WORDS]) {
+  words[0] = r->mwc_seed;
+  words[1] = r->mwc_position;
+}
+
+#define CUID_SNAPSHOT_RANDOM_PTR mwc_snapshot_ptr
+
+/*
+** Always returns 1, any seed and position make a valid state.
+*/
+static inline int
+mwc_restore_ptr(mwc_random_t *r, uint64_t const words[MWC_SNAPSHOT_WORDS]) {
+  mwc_seed_ptr(r, words[0]);
+  mwc_skip_ptr(r, words[1]);
+  return 1;
+}
+#else
+/*
+** The snapshot of a mwc random state filled by the system random is its
+** whole state, about 32KB, so it is restored in constant time: the lag
+** table, two numbers per word, followed by a word with the carry and the
+** position in the table, and then the initial lag table and carry that
+** `mwc_init` resets to in the same form.
+*/
+#define MWC_SNAPSHOT_WORDS (MWC_CYCLE + 2)
+
+/*
+** Internal method that packs the lag table `q`, and the `high` and `low`
+** numbers of its last word, into MWC_CYCLE / 2 + 1 snapshot `words`.
+*/
+static inline void
+mwc_snapshot_table(uint32_t const q[CUID_STATIC MWC_CYCLE],
+                   uint32_t const high,
+                   uint32_t const low,
+                   uint64_t *words) {
+  for (size_t i = 0; i < MWC_CYCLE; i += 2) {
+    words[i / 2] = (uint64_t)q[i] << 32 | q[i + 1];
+  }
+  words[MWC_CYCLE / 2] = (uint64_t)high << 32 | low;
+}
+
+/*
+** Internal method that unpacks the snapshot `words` of `mwc_snapshot_table`
+** into the lag table `q`.
+** Returns the last word, with the carry in its high 32 bits.
+*/
+static inline uint64_t
+mwc_restore_table(uint32_t q[CUID_STATIC MWC_CYCLE], uint64_t const *words) {
+  for (size_t i = 0; i < MWC_CYCLE; i += 2) {
+    q[i] = (uint32_t)(words[i / 2] >> 32);
+    q[i + 1] = (uint32_t)words[i / 2];
+  }
+  return words[MWC_CYCLE / 2];
+}
+
+static inline void
+mwc_snapshot_ptr(mwc_random_t const *r, uint64_t words[MWC_SNAPSHOT_WORDS]) {
+  mwc_snapshot_table(r->mwc_q, r->mwc_carry, r->mwc_current_cycle, words);
+  mwc_snapshot_table(r->mwc_initial_q, r->mwc_initial_carry, 0,
+                     &words[MWC_CYCLE / 2 + 1]);
+}
+
+#define CUID_SNAPSHOT_RANDOM_PTR mwc_snapshot_ptr
+
+/*
+** Returns 0 if the carries or the position in the table are out of range.
+*/
+static inline int
+mwc_restore_ptr(mwc_random_t *r, uint64_t const words[MWC_SNAPSHOT_WORDS]) {
+  uint64_t const last = mwc_restore_table(r->mwc_q, words);
+  r->mwc_carry = (uint32_t)(last >> 32);
+  r->mwc_current_cycle = (unsigned)(last & 0xffffffffU);
+  if (r->mwc_carry >= MWC_C_MAX || r->mwc_current_cycle >= MWC_CYCLE) {
+    return 0;
+  }
+  uint64_t const initial =
+    mwc_restore_table(r->mwc_initial_q, &words[MWC_CYCLE / 2 + 1]);
+  r->mwc_initial_carry = (uint32_t)(initial >> 32);
+  if (r->mwc_initial_carry >= MWC_C_MAX) {
+    return 0;
+  }
+  return 1;
+}
+#endif /* CUID_MWC_SEEDED */
+
+#define CUID_RESTORE_RANDOM_PTR mwc_restore_ptr
+#define CUID_RANDOM_SNAPSHOT_WORDS MWC_SNAPSHOT_WORDS
+
+#endif // CUID_RANDOM_T
+
+/*
+** Default in-place hooks for counter and random overrides that only provide
+** the value based functions.
+*/
+#ifndef CUID_INIT_COUNTER_PTR
+#define CUID_INIT_COUNTER_PTR(c) (*(c) = CUID_INIT_COUNTER(*(c)))
+#endif
+#ifndef CUID_READ_COUNTER_PTR
+#define CUID_READ_COUNTER_PTR(c) CUID_READ_COUNTER(*(c))
+#endif
+#ifndef CUID_INCREASE_COUNTER_PTR
+#define CUID_INCREASE_COUNTER_PTR(c) (*(c) = CUID_INCREASE_COUNTER(*(c)))
+#endif
+#ifndef CUID_CREATE_RANDOM_PTR
+#define CUID_CREATE_RANDOM_PTR(r) (*(r) = CUID_CREATE_RANDOM())
+#endif
+#ifndef CUID_INIT_RANDOM_PTR
+#define CUID_INIT_RANDOM_PTR(r) (*(r) = CUID_INIT_RANDOM(*(r)))
+#endif
+#ifndef CUID_READ_RANDOM_PTR
+#define CUID_READ_RANDOM_PTR(r) CUID_READ_RANDOM(*(r))
+#endif
+#ifndef CUID_NEXT_RANDOM_PTR
+#define CUID_NEXT_RANDOM_PTR(r) (*(r) = CUID_NEXT_RANDOM(*(r)))
+#endif
+#ifndef CUID_FILL_RANDOM_PTR
+static inline void
+cuid_fill_random_ptr(CUID_RANDOM_T *r, uint32_t *out, size_t const n) {
+  for (size_t i = 0; i < n; ++i) {
+    CUID_NEXT_RANDOM_PTR(r);
+    out[i] = CUID_READ_RANDOM_PTR(r);
+  }
+}
+#define CUID_FILL_RANDOM_PTR cuid_fill_random_ptr
+#endif /* CUID_FILL_RANDOM_PTR */
+/*
+** The reseed hooks receive a 64 bit seed. A random implementation without
+** one is created again instead, a counter without one is left unchanged.
+*/
+#ifndef CUID_RESEED_RANDOM_PTR
+#define CUID_RESEED_RANDOM_PTR(r, seed) \
+  ((void)(seed), CUID_CREATE_RANDOM_PTR(r))
+#endif
+#ifndef CUID_RESEED_COUNTER_PTR
+#define CUID_RESEED_COUNTER_PTR(c, seed) ((void)(c), (void)(seed))
+#endif
+/*
+** The skip hooks advance a random generator or a counter by `n` steps. Their
+** defaults step `n` times.
+*/
+#ifndef CUID_SKIP_RANDOM_PTR
+static inline void
+cuid_skip_random_ptr(CUID_RANDOM_T *r, uint64_t const n) {
+  for (uint64_t i = 0; i < n; ++i) {
+    CUID_NEXT_RANDOM_PTR(r);
+  }
+}
+#define CUID_SKIP_RANDOM_PTR cuid_skip_random_ptr
+#endif /* CUID_SKIP_RANDOM_PTR */
+#ifndef CUID_SKIP_COUNTER_PTR
+static inline void
+cuid_skip_counter_ptr(CUID_COUNTER_T *c, uint64_t const n) {
+  for (uint64_t i = 0; i < n; ++i) {
+    CUID_INCREASE_COUNTER_PTR(c);
+  }
+}
+#define CUID_SKIP_COUNTER_PTR cuid_skip_counter_ptr
+#endif /* CUID_SKIP_COUNTER_PTR */
+
+#ifndef CUID_GET_PID
+#include <unistd.h> // getpid
+#define CUID_GET_PID getpid
+#endif /* CUID_GET_PID */
+
+/*
+** The fork detection of the pure API, with CUID_FORK_SAFE.
+**
+** Each `cuid_t` keeps the fork epoch it was seeded in. A `pthread_atfork()`
+** child handler, registered by `cuid_create_inplace`, increases the epoch in
+** each forked child. The first cuid of a `cuid_t` inherited by a child then
+** finds a different epoch and reseeds the state instead of repeating the
+** cuids of the parent.
+**
+** Define CUID_FORK_EPOCH to detect new processes in another way, it must
+** return a `uint32_t` that is different in each child.
+*/
+#if defined(CUID_FORK_SAFE) && !defined(CUID_FORK_EPOCH)
+#include <pthread.h> // pthread_atfork, pthread_once
+
+// Only written by the child handler, while the child has a single thread
+static uint32_t cuid_fork_epoch = 0;
+
+static void
+cuid_fork_epoch_child(void) {
+  cuid_fork_epoch++;
+}
+
+static void
+cuid_fork_epoch_register(void) {
+  pthread_atfork(0x0, 0x0, cuid_fork_epoch_child);
+}
+
+static inline uint32_t
+cuid_fork_epoch_read(void) {
+  return cuid_fork_epoch;
+}
+#define CUID_FORK_EPOCH cuid_fork_epoch_read
+#define CUID_FORK_EPOCH_WATCH() do {                                   \
+    static pthread_once_t cuid_fork_epoch_once = PTHREAD_ONCE_INIT;    \
+    pthread_once(&cuid_fork_epoch_once, cuid_fork_epoch_register);     \
+  } while (0)
+#endif /* CUID_FORK_SAFE */
+#ifndef CUID_FORK_EPOCH_WATCH
+#define CUID_FORK_EPOCH_WATCH() do { } while (0)
+#endif /* CUID_FORK_EPOCH_WATCH */
+
+/*
+** The data type for the state of the cuid pure API.
+**
+** Every block is formatted straight into `cuid_value`. The fingerprint block
+** is written there once by `cuid_create_inplace` and the timestamp block
+** only when the timestamp changes, advancing the state only formats the
+** counter and random blocks. With a compact PRNG, like PCG32, a `cuid_t`
+** fits in a single 64 bytes cache line (CUID_FORK_SAFE adds 4 bytes, and
+** CUID_STATS 40 bytes of counters).
+*/
+typedef struct cuid_t {
+  // Random values, limited to 4 chars, it uses two rng's that get
+  // merged in the final 8 chars of the value, or a single one when the
+  // random implementation can peek at its next number.
+#ifdef CUID_PEEK_RANDOM_PTR
+  CUID_RANDOM_T cuid_rnd;
+#else
+  CUID_RANDOM_T cuid_rnd1;
+  CUID_RANDOM_T cuid_rnd2;
+#endif
+  // The timestamp value that the timestamp block was encoded from, this
+  // allows it to be encoded only when the timestamp changes.
+  unsigned long cuid_timestamp_value;
+  // Counter, limited to 4 chars
+  CUID_COUNTER_T cuid_counter;
+  // The number of cuids made with this timestamp, see `cuid_next_checked`
+  uint32_t cuid_tick_count;
+#ifdef CUID_FORK_SAFE
+  // The fork epoch that the state was seeded in
+  uint32_t cuid_fork_epoch;
+#endif /* CUID_FORK_SAFE */
+#ifdef CUID_STATS
+  // The counters of this state, see `cuid_stats_read`
+  cuid_stats_t cuid_stats;
+#endif /* CUID_STATS */
+  // The cuid string generated
+  char cuid_value[CUID_SIZE];
+} cuid_t;
+
+/*
+** Internal functions that create, initialize, advance and read the random
+** numbers of a `cuid_t`, these hide if one or two generators are being used.
+*/
+static inline void
+cuid_create_randoms_inplace(cuid_t *id) {
+#ifdef CUID_PEEK_RANDOM_PTR
+  CUID_CREATE_RANDOM_PTR(&id->cuid_rnd);
+#else
+  CUID_CREATE_RANDOM_PTR(&id->cuid_rnd1);
+  CUID_CREATE_RANDOM_PTR(&id->cuid_rnd2);
+#endif
+}
+
+static inline void
+cuid_init_randoms_inplace(cuid_t *id) {
+#ifdef CUID_PEEK_RANDOM_PTR
+  CUID_INIT_RANDOM_PTR(&id->cuid_rnd);
+#else
+  CUID_INIT_RANDOM_PTR(&id->cuid_rnd1);
+  CUID_INIT_RANDOM_PTR(&id->cuid_rnd2);
+#endif
+}
+
+static inline void
+cuid_next_randoms_inplace(cuid_t *id) {
+#ifdef CUID_PEEK_RANDOM_PTR
+  CUID_NEXT_RANDOM_PTR(&id->cuid_rnd);
+  CUID_NEXT_RANDOM_PTR(&id->cuid_rnd);
+#else
+  CUID_NEXT_RANDOM_PTR(&id->cuid_rnd1);
+  CUID_NEXT_RANDOM_PTR(&id->cuid_rnd2);
+#endif
+}
+
+static inline uint32_t
+cuid_read_random1_ptr(cuid_t const *id) {
+#ifdef CUID_PEEK_RANDOM_PTR
+  return CUID_READ_RANDOM_PTR(&id->cuid_rnd);
+#else
+  return CUID_READ_RANDOM_PTR(&id->cuid_rnd1);
+#endif
+}
+
+static inline uint32_t
+cuid_read_random2_ptr(cuid_t const *id) {
+#ifdef CUID_PEEK_RANDOM_PTR
+  return CUID_PEEK_RANDOM_PTR(&id->cuid_rnd);
+#else
+  return CUID_READ_RANDOM_PTR(&id->cuid_rnd2);
+#endif
+}
+
+/*
+** Advances the random numbers of a `cuid_t` by `n` cuids and writes the
+** numbers of their random blocks into `rnds1` and `rnds2`, as `n` calls to
+** `cuid_next_randoms_inplace` each followed by `cuid_read_random1_ptr` and
+** `cuid_read_random2_ptr` would.
+**
+** A single generator makes two numbers per cuid, the second one peeked
+** after the state of the cuid. It is filled with these in pieces of
+** CUID_FILL_PIECE cuids: the second block of each cuid is the first number
+** of the next one.
+*/
+#define CUID_FILL_PIECE (32)
+static inline void
+cuid_fill_randoms_inplace(cuid_t *id,
+                          size_t const n,
+                          uint32_t *rnds1,
+                          uint32_t *rnds2) {
+#ifdef CUID_PEEK_RANDOM_PTR
+  uint32_t numbers[2 * CUID_FILL_PIECE];
+  for (size_t start = 0; start < n; start += CUID_FILL_PIECE) {
+    size_t const count = n - start < CUID_FILL_PIECE ?
+                         n - start : CUID_FILL_PIECE;
+    CUID_FILL_RANDOM_PTR(&id->cuid_rnd, numbers, 2 * count);
+    CUID_STATS_ADD(&id->cuid_stats, cuid_random_refills, 1);
+    for (size_t i = 0; i + 1 < count; ++i) {
+      rnds1[start + i] = numbers[2 * i + 1];
+      rnds2[start + i] = numbers[2 * i + 2];
+    }
+    rnds1[start + count - 1] = numbers[2 * count - 1];
+    rnds2[start + count - 1] = CUID_PEEK_RANDOM_PTR(&id->cuid_rnd);
+  }
+#else
+  CUID_FILL_RANDOM_PTR(&id->cuid_rnd1, rnds1, n);
+  CUID_FILL_RANDOM_PTR(&id->cuid_rnd2, rnds2, n);
+  CUID_STATS_ADD(&id->cuid_stats, cuid_random_refills, 2);
+#endif
+}
+
+/*
+** Increases a counter of `id`, counting it in the stats of `id` when its
+** block goes back to a lower number.
+*/
+static inline void
+cuid_increase_counter_inplace(cuid_t *id, CUID_COUNTER_T *counter) {
+#ifdef CUID_STATS
+  uint32_t const previous = CUID_READ_COUNTER_PTR(counter) % CUID_COUNTER_MAX;
+  CUID_INCREASE_COUNTER_PTR(counter);
+  id->cuid_stats.cuid_counter_wraps +=
+    CUID_READ_COUNTER_PTR(counter) % CUID_COUNTER_MAX < previous;
+#else
+  (void)id;
+  CUID_INCREASE_COUNTER_PTR(counter);
+#endif /* CUID_STATS */
+}
+
+/*
+** Moves a counter of `id` by `n`, counting in the stats of `id` the times
+** its block goes back to a lower number on the way.
+*/
+static inline void
+cuid_skip_counter_inplace(cuid_t *id,
+                          CUID_COUNTER_T *counter,
+                          uint64_t const n) {
+#ifdef CUID_STATS
+  uint64_t const previous = CUID_READ_COUNTER_PTR(counter) % CUID_COUNTER_MAX;
+  id->cuid_stats.cuid_counter_wraps += (previous + n) / CUID_COUNTER_MAX;
+#else
+  (void)id;
+#endif /* CUID_STATS */
+  CUID_SKIP_COUNTER_PTR(counter, n);
+}
+
+static inline void
+cuid_reseed_randoms_inplace(cuid_t *id, uint64_t *seed) {
+#ifdef CUID_PEEK_RANDOM_PTR
+  CUID_RESEED_RANDOM_PTR(&id->cuid_rnd, cuid_splitmix64(seed));
+#else
+  CUID_RESEED_RANDOM_PTR(&id->cuid_rnd1, cuid_splitmix64(seed));
+  CUID_RESEED_RANDOM_PTR(&id->cuid_rnd2, cuid_splitmix64(seed));
+#endif
+}
+
+/*
+** Returns 64 bits of fresh entropy from MWC_SYSTEM_RAND32, to reseed a
+** `cuid_t` with.
+*/
+static inline uint64_t
+cuid_fresh_entropy(void) {
+  return (uint64_t)MWC_SYSTEM_RAND32() << 32 | MWC_SYSTEM_RAND32();
+}
+
+/*
+** Reseeds the `cuid_t` pointed by `id` from the 64 bits of `entropy` and the
+** pid of the process, e.g. in a child process after `fork()`.
+**
+** The random generators and the counter are perturbed in place through the
+** CUID_RESEED_RANDOM_PTR and CUID_RESEED_COUNTER_PTR hooks, which is much
+** cheaper than creating them again with `cuid_create_inplace`. The
+** fingerprint and timestamp blocks are kept.
+*/
+static inline void
+cuid_reseed_inplace(cuid_t *id, uint64_t const entropy) {
+  uint64_t seed = entropy ^ (uint64_t)CUID_GET_PID() << 32;
+  CUID_RESEED_COUNTER_PTR(&id->cuid_counter, cuid_splitmix64(&seed));
+  cuid_reseed_randoms_inplace(id, &seed);
+  CUID_STATS_ADD(&id->cuid_stats, cuid_reseeds, 1);
+#ifdef CUID_FORK_SAFE
+  id->cuid_fork_epoch = CUID_FORK_EPOCH();
+#endif /* CUID_FORK_SAFE */
+}
+
+/*
+** Internal function that reseeds the `cuid_t` pointed by `id` when it was
+** inherited by a forked child, with CUID_FORK_SAFE. Does nothing otherwise.
+*/
+static inline void
+cuid_check_fork_inplace(cuid_t *id) {
+#ifdef CUID_FORK_SAFE
+  if (id->cuid_fork_epoch != CUID_FORK_EPOCH()) {
+    cuid_reseed_inplace(id, cuid_fresh_entropy());
+  }
+#else
+  (void)id;
+#endif /* CUID_FORK_SAFE */
+}
+
+/*
+** Creates a `cuid_t` data type in place, at the memory pointed by `id`, by
+** calling the *_create functions for each of its attributes that need them
+** to be called.
+**
+** With the default MWC PRNG the `cuid_t` is large (it holds the state of two
+** PRNGs), the `*_inplace` functions and `cuid_read_ptr` work through a
+** pointer to avoid copying it at each call.
+*/
+static inline void
+cuid_create_inplace(cuid_t *id,
+                    char const fingerprint[CUID_STATIC CUID_FINGERPRINT_SIZE]) {
+  id->cuid_counter = CUID_CREATE_COUNTER();
+  cuid_create_randoms_inplace(id);
+  // Clear the value
+  for (size_t i = 0; i < CUID_SIZE; ++i) {
+    id->cuid_value[i] = '\0';
+  }
+  // No timestamp was encoded yet
+  id->cuid_timestamp_value = ULONG_MAX;
+  id->cuid_tick_count = 0;
+#ifdef CUID_STATS
+  cuid_stats_t const no_stats = {0, 0, 0, 0, 0};
+  id->cuid_stats = no_stats;
+#endif /* CUID_STATS */
+#ifdef CUID_FORK_SAFE
+  CUID_FORK_EPOCH_WATCH();
+  id->cuid_fork_epoch = CUID_FORK_EPOCH();
+#endif /* CUID_FORK_SAFE */
+  // Copy the fingerprint from the argument into its block
+  for (size_t i = 0; i < CUID_BLOCK_LENGTH; ++i) {
+    id->cuid_value[CUID_FINGERPRINT_OFFSET + i] = fingerprint[i];
+  }
+}
+
+/*
+** Creates a `cuid_t` data type by calling the *_create functions
+** for each of its attributes that need them to be called.
+*/ 
+static inline cuid_t
+cuid_create(char const fingerprint[CUID_STATIC CUID_FINGERPRINT_SIZE]) {
+  cuid_t id;
+  cuid_create_inplace(&id, fingerprint);
+  return id;
+}
+
+/*
+** Internal method that sets the value string of the `cuid_t` pointed by
+** `id` from its state.
+** This is used to generate a cuid in the value array, ready to be read,
+** at the init and next functions. The timestamp and fingerprint blocks are
+** already in place.
+*/
+static inline void
+cuid_gen_value_string_inplace(cuid_t *id) {
+  // Counter (4 chars)
+  cuid_base36_block(CUID_READ_COUNTER_PTR(&id->cuid_counter),
+                    &id->cuid_value[CUID_COUNTER_OFFSET]);
+  // Random block 1 (4 chars)
+  cuid_base36_block(cuid_read_random1_ptr(id),
+                    &id->cuid_value[CUID_RANDOM1_OFFSET]);
+  // Random block 2 (4 chars)
+  cuid_base36_block(cuid_read_random2_ptr(id),
+                    &id->cuid_value[CUID_RANDOM2_OFFSET]);
+}
+
+/*
+** Formats the cuid of the current state of the `cuid_t` pointed by `id`
+** straight into `destination`, without touching the value of `id`.
+** The cuid is '\0' terminated, its length is returned.
+*/
+static inline size_t
+cuid_format(cuid_t const *id, char destination[CUID_STATIC CUID_SIZE]) {
+  // Letter, timestamp and fingerprint, as cached in the value
+  for (size_t i = 0; i < CUID_COUNTER_OFFSET; ++i) {
+    destination[i] = id->cuid_value[i];
+  }
+  for (size_t i = 0; i < CUID_BLOCK_LENGTH; ++i) {
+    destination[CUID_FINGERPRINT_OFFSET + i] =
+      id->cuid_value[CUID_FINGERPRINT_OFFSET + i];
+  }
+  cuid_base36_block(CUID_READ_COUNTER_PTR(&id->cuid_counter),
+                    &destination[CUID_COUNTER_OFFSET]);
+  cuid_base36_block(cuid_read_random1_ptr(id),
+                    &destination[CUID_RANDOM1_OFFSET]);
+  cuid_base36_block(cuid_read_random2_ptr(id),
+                    &destination[CUID_RANDOM2_OFFSET]);
+  destination[CUID_SIZE - 1] = '\0';
+  return CUID_SIZE - 1;
+}
+
+/*
+** Internal method that returns a cuid_t with a value string set
+** from its state.
+*/
+static inline cuid_t
+cuid_gen_value_string(cuid_t id) {
+  cuid_gen_value_string_inplace(&id);
+  return id;
+}
+
+/*
+** Internal method that encodes the timestamp block of the cuid_t pointed by
+** `id`, if the timestamp changed since the last time it was encoded.
+*/
+static inline void
+cuid_set_timestamp_inplace(cuid_t *id, unsigned long const timestamp) {
+  if (timestamp != id->cuid_timestamp_value) {
+    cuid_base36_timestamp(timestamp, &id->cuid_value[CUID_TIMESTAMP_OFFSET]);
+    id->cuid_timestamp_value = timestamp;
+    CUID_STATS_ADD(&id->cuid_stats, cuid_timestamp_changes, 1);
+  }
+}
+
+/*
+** Initializes the cuid_t pointed by `id` in place.
+** Sets the timestamp block of the cuid value to be the base36 string of the
+** provided argument and generates the first value.
+** Calls the initializes of each of the cuid_t attributes that need them to be
+** called.
+*/
+static inline void
+cuid_init_inplace(cuid_t *id, unsigned long const timestamp) {
+  cuid_check_fork_inplace(id);
+  // Initialize the counter
+  CUID_INIT_COUNTER_PTR(&id->cuid_counter);
+  // Initialize the PRNG's
+  cuid_init_randoms_inplace(id);
+  // Letter
+  id->cuid_value[0] = 'c';
+  id->cuid_value[CUID_SIZE - 1] = '\0';
+  // Set the timestamp
+  cuid_base36_timestamp(timestamp, &id->cuid_value[CUID_TIMESTAMP_OFFSET]);
+  id->cuid_timestamp_value = timestamp;
+  // The initial value is the first cuid of this timestamp
+  id->cuid_tick_count = 1;
+  // Generate a new value string
+  cuid_gen_value_string_inplace(id);
+}
+
+/*
+** Initializes a cuid_t data type.
+** Returns an initialized cuid_t, see `cuid_init_inplace`.
+*/
+static inline cuid_t
+cuid_init(cuid_t id, unsigned long const timestamp) {
+  cuid_init_inplace(&id, timestamp);
+  return id;
+}
+
+/*
+** Reads the cuid string value from the cuid_t pointed by `id`.
+**
+** The value is copied into the `destination` char array passed as arg.
+**
+** Define the macro CUID_LAZY to have the next functions only advance the
+** numbers of the state and the cuid string formatted here, straight into
+** `destination`, with `cuid_format`. This is faster when more cuids are
+** generated than read, or when they are only used in their binary form (see
+** `cuid_bin_from_state`). The value of the `cuid_t` then only keeps the
+** letter, timestamp and fingerprint blocks up to date.
+*/
+static inline void
+cuid_read_ptr(cuid_t const *id, char destination[CUID_STATIC CUID_SIZE]) {
+#ifdef CUID_LAZY
+  cuid_format(id, destination);
+#else
+  for (size_t i = 0; i < CUID_SIZE; ++i) {
+    destination[i] = id->cuid_value[i];
+  }
+#endif /* CUID_LAZY */
+}
+
+/*
+** Places the counters of the provided cuid_t in `stats`, they are all 0
+** without CUID_STATS. A copy of a `cuid_t` starts with the counters of the
+** original, except for the substreams made by `cuid_split`.
+*/
+static inline void
+cuid_stats_read(cuid_t const *id, cuid_stats_t *stats) {
+#ifdef CUID_STATS
+  *stats = id->cuid_stats;
+#else
+  (void)id;
+  cuid_stats_t const no_stats = {0, 0, 0, 0, 0};
+  *stats = no_stats;
+#endif /* CUID_STATS */
+}
+
+/*
+** Reads the cuid string value from the provided cuid_t.
+**
+** The value is copied into the `destination` char array passed as arg.
+*/
+static inline void
+cuid_read(cuid_t const id, char destination[CUID_STATIC CUID_SIZE]) {
+  cuid_read_ptr(&id, destination);
+}
+
+#ifdef CUID_ORDERED
+/*
+** Returns the timestamp of the next time ordered cuid after one made with
+** the timestamp `last` (ULONG_MAX if there is none) and the counter `count`:
+** `timestamp`, or `last` when `timestamp` is older, or the next millisecond
+** when `count + 1` does not fit in the counter block.
+*/
+static inline unsigned long
+cuid_ordered_tick(unsigned long const last,
+                  uint32_t const count,
+                  unsigned long const timestamp) {
+  if (last != ULONG_MAX && timestamp <= last) {
+    return count + 1 < CUID_COUNTER_MAX ? last : last + 1;
+  }
+  return timestamp;
+}
+
+/*
+** Internal method that increases the `counter` of the next time ordered cuid
+** of `id` and returns the timestamp of that cuid, see `cuid_ordered_tick`.
+** The counter starts again with CUID_INIT_COUNTER_PTR at each new timestamp.
+*/
+static inline unsigned long
+cuid_ordered_advance_inplace(cuid_t *id,
+                             CUID_COUNTER_T *counter,
+                             unsigned long const timestamp) {
+  unsigned long const last = id->cuid_timestamp_value;
+  unsigned long const tick =
+    cuid_ordered_tick(last, id->cuid_tick_count, timestamp);
+  if (tick != last) {
+    CUID_INIT_COUNTER_PTR(counter);
+    id->cuid_tick_count = 0;
+  }
+  id->cuid_tick_count += 1;
+  cuid_increase_counter_inplace(id, counter);
+  return tick;
+}
+
+/*
+** Internal method that moves the counter of the time ordered cuid_t pointed
+** by `id` by `n` cuids made with its current timestamp, and returns the
+** timestamp of the last one: the same as `n` calls to
+** `cuid_ordered_advance_inplace`, where each full timestamp moves on to the
+** next millisecond and starts the counter again.
+*/
+static inline unsigned long
+cuid_ordered_skip_inplace(cuid_t *id, uint64_t const n) {
+  unsigned long const last = id->cuid_timestamp_value;
+  // The cuids that a timestamp holds, see `cuid_ordered_tick`
+  uint64_t const per_tick = CUID_COUNTER_MAX - 1;
+  uint64_t const count = id->cuid_tick_count;
+  uint64_t const left = count < per_tick ? per_tick - count : 0;
+  if (last == ULONG_MAX || n <= left) {
+    uint64_t const total = count + n;
+    id->cuid_tick_count =
+      total < CUID_COUNTER_MAX ? (uint32_t)total : CUID_COUNTER_MAX;
+    cuid_skip_counter_inplace(id, &id->cuid_counter, n);
+    return last;
+  }
+  cuid_skip_counter_inplace(id, &id->cuid_counter, left);
+  // The others fill the next timestamps, the last one holds `in_last`
+  uint64_t const rest = n - left;
+  uint64_t const ticks = (rest - 1) / per_tick + 1;
+  uint64_t const in_last = (rest - 1) % per_tick + 1;
+  CUID_INIT_COUNTER_PTR(&id->cuid_counter);
+#ifdef CUID_STATS
+  uint64_t const initial =
+    CUID_READ_COUNTER_PTR(&id->cuid_counter) % CUID_COUNTER_MAX;
+  id->cuid_stats.cuid_counter_wraps +=
+    (ticks - 1) * ((initial + per_tick) / CUID_COUNTER_MAX);
+  // The last timestamp change is counted when it is set
+  id->cuid_stats.cuid_timestamp_changes += ticks - 1;
+#endif /* CUID_STATS */
+  cuid_skip_counter_inplace(id, &id->cuid_counter, in_last);
+  id->cuid_tick_count = (uint32_t)in_last;
+  return last + (unsigned long)ticks;
+}
+#endif /* CUID_ORDERED */
+
+#ifndef CUID_ORDERED
+/*
+** Internal method that counts `n` more cuids made by `id` with `timestamp`,
+** before it is set. The count starts again at each new timestamp and stops
+** at CUID_COUNTER_MAX, which is all that `cuid_next_checked` needs.
+*/
+static inline void
+cuid_count_ticks_inplace(cuid_t *id,
+                         unsigned long const timestamp,
+                         uint64_t const n) {
+  uint64_t const count =
+    (timestamp == id->cuid_timestamp_value ? id->cuid_tick_count : 0) + n;
+  id->cuid_tick_count =
+    count < CUID_COUNTER_MAX ? (uint32_t)count : CUID_COUNTER_MAX;
+}
+#endif /* CUID_ORDERED */
+
+/*
+** Advances the numbers of the cuid_t pointed by `id` into the next state, in
+** place, without formatting the counter and random blocks of its value.
+** The cuid can then be formatted with `cuid_format` or packed with
+** `cuid_bin_from_state`.
+*/
+static inline void
+cuid_advance_inplace(cuid_t *id, unsigned long const timestamp) {
+  cuid_check_fork_inplace(id);
+  // Increase the counter
+#ifdef CUID_ORDERED
+  unsigned long const tick =
+    cuid_ordered_advance_inplace(id, &id->cuid_counter, timestamp);
+#else
+  unsigned long const tick = timestamp;
+  cuid_count_ticks_inplace(id, timestamp, 1);
+  cuid_increase_counter_inplace(id, &id->cuid_counter);
+#endif /* CUID_ORDERED */
+  CUID_STATS_ADD(&id->cuid_stats, cuid_generated, 1);
+  // and the PRNGs,
+  cuid_next_randoms_inplace(id);
+  // and set the timestamp
+  cuid_set_timestamp_inplace(id, tick);
+}
+
+/*
+** Advances the cuid_t pointed by `id` into the next state, in place.
+** This function creates the new random values and sets the timestamp string
+** into the cuid value string (only the numbers with CUID_LAZY).
+**
+** A new cuid string can then be read from `id` with `cuid_read_ptr`.
+*/
+static inline void
+cuid_next_inplace(cuid_t *id, unsigned long const timestamp) {
+  CUID_TRACE_BEGIN("cuid_next_inplace");
+  cuid_advance_inplace(id, timestamp);
+#ifndef CUID_LAZY
+  // Generate a new value string into the id
+  cuid_gen_value_string_inplace(id);
+#endif /* CUID_LAZY */
+  CUID_TRACE_END("cuid_next_inplace");
+}
+
+/*
+** Advances the cuid_t pointed by `id` by `n` cuids, in place: it is left in
+** the state, and with the stats, that `n` calls to `cuid_next_inplace`, with
+** its current timestamp, would leave it in. With CUID_ORDERED this moves on
+** to the next milliseconds when the counters of the timestamp are used up.
+**
+** The counter and random generators are moved with the CUID_SKIP_COUNTER_PTR
+** and CUID_SKIP_RANDOM_PTR hooks. PCG32 jumps ahead in O(log n), but the
+** default MWC has no jump ahead and generates the 2 * n numbers one by one,
+** so define CUID_RANDOM_PCG32 to skip far ahead.
+*/
+static inline void
+cuid_skip_inplace(cuid_t *id, uint64_t const n) {
+  cuid_check_fork_inplace(id);
+#ifdef CUID_ORDERED
+  unsigned long const tick = cuid_ordered_skip_inplace(id, n);
+#else
+  cuid_count_ticks_inplace(id, id->cuid_timestamp_value, n);
+  cuid_skip_counter_inplace(id, &id->cuid_counter, n);
+#endif /* CUID_ORDERED */
+  CUID_STATS_ADD(&id->cuid_stats, cuid_generated, n);
+#ifdef CUID_PEEK_RANDOM_PTR
+  // Each cuid takes two numbers from the single generator
+  CUID_SKIP_RANDOM_PTR(&id->cuid_rnd, 2 * n);
+#else
+  CUID_SKIP_RANDOM_PTR(&id->cuid_rnd1, n);
+  CUID_SKIP_RANDOM_PTR(&id->cuid_rnd2, n);
+#endif /* CUID_PEEK_RANDOM_PTR */
+#ifdef CUID_ORDERED
+  cuid_set_timestamp_inplace(id, tick);
+#endif /* CUID_ORDERED */
+#ifndef CUID_LAZY
+  cuid_gen_value_string_inplace(id);
+#endif /* CUID_LAZY */
+}
+
+/*
+** Splits the cuid_t pointed by `id` into `k` substreams, written into the
+** `substreams` array, to share one generator among `k` workers without
+** coordination.
+**
+** The substream 0 is a copy of `id`. Each of the others moves its counter
+** to its own `CUID_COUNTER_MAX / k` range and its random generators to
+** another sequence with the CUID_RESEED_RANDOM_PTR hook, seeded from the
+** current random numbers and counter of `id`, so the substreams of
+** different states get different sequences. The counters of the
+** substreams do not overlap while each one makes fewer than
+** `CUID_COUNTER_MAX / k` cuids with the same timestamp. The result is the
+** same for the same `id` and `k`.
+*/
+static inline void
+cuid_split(cuid_t const *id, size_t const k, cuid_t *substreams) {
+  uint64_t const range = k > 0 ? CUID_COUNTER_MAX / k : 0;
+  // Each substream takes its seeds from the next numbers of this sequence
+  uint64_t seed = ((uint64_t)cuid_read_random1_ptr(id) << 32
+                   | cuid_read_random2_ptr(id))
+                  ^ CUID_READ_COUNTER_PTR(&id->cuid_counter);
+  for (size_t i = 0; i < k; ++i) {
+    cuid_t *substream = &substreams[i];
+    *substream = *id;
+    if (i == 0) {
+      continue;
+    }
+#ifdef CUID_STATS
+    // The counters of the original are only kept by the first substream
+    cuid_stats_t const no_stats = {0, 0, 0, 0, 0};
+    substream->cuid_stats = no_stats;
+#endif /* CUID_STATS */
+    CUID_SKIP_COUNTER_PTR(&substream->cuid_counter, i * range);
+    cuid_reseed_randoms_inplace(substream, &seed);
+#ifndef CUID_LAZY
+    cuid_gen_value_string_inplace(substream);
+#endif /* CUID_LAZY */
+  }
+}
+
+/*
+** Advances the provided cuid_t into the next state.
+**
+** It returns a new cuid_t with the new state to be used to read the cuid
+** string, see `cuid_next_inplace`.
+**
+** A new cuid string can then be read from the returned id with `cuid_read`.
+** 
+*/
+static inline cuid_t
+cuid_next(cuid_t id, unsigned long const timestamp) {
+  cuid_next_inplace(&id, timestamp);
+  return id;
+}
+
+/*
+** Packs the cuid of the current state of the `cuid_t` pointed by `id` into
+** its binary form, straight from its numbers, see `cuid_bin_encode`.
+** Returns 1 on success, 0 if the fingerprint is not made of base36 digits.
+*/
+static inline int
+cuid_bin_from_state(cuid_t const *id, cuid_bin_t *cuid_bin) {
+  uint64_t fingerprint = 0;
+  if (!cuid_base36_decode(&id->cuid_value[CUID_FINGERPRINT_OFFSET],
+                          CUID_BLOCK_LENGTH, &fingerprint)) {
+    return 0;
+  }
+  // Each block keeps the lowest digits of its number
+  uint64_t const timestamp_max = cuid_base36_powers[CUID_TIMESTAMP_LENGTH];
+  uint8_t *blocks = &cuid_bin->bytes[CUID_BIN_TIMESTAMP_SIZE];
+  cuid_bin_store(cuid_bin->bytes, id->cuid_timestamp_value % timestamp_max,
+                 CUID_BIN_TIMESTAMP_SIZE);
+  cuid_bin_store(&blocks[0],
+                 CUID_READ_COUNTER_PTR(&id->cuid_counter) % CUID_COUNTER_MAX,
+                 CUID_BIN_BLOCK_SIZE);
+  cuid_bin_store(&blocks[3], fingerprint, CUID_BIN_BLOCK_SIZE);
+  cuid_bin_store(&blocks[6], cuid_read_random1_ptr(id) % CUID_COUNTER_MAX,
+                 CUID_BIN_BLOCK_SIZE);
+  cuid_bin_store(&blocks[9], cuid_read_random2_ptr(id) % CUID_COUNTER_MAX,
+                 CUID_BIN_BLOCK_SIZE);
+  return 1;
+}
+
+/*
+** The snapshot of a `cuid_t`: a versioned and portable form of its state, to
+** save and restore a generator (e.g. for test fixtures or crash recovery
+** checkpoints).
+**
+** A snapshot is CUID_SNAPSHOT_SIZE bytes: a version byte, the snapshot words
+** of each random generator, the counter, the timestamp, the tick count and
+** the fingerprint, with the numbers stored in big-endian order.
+**
+** It is available when the random implementation defines the
+** CUID_SNAPSHOT_RANDOM_PTR and CUID_RESTORE_RANDOM_PTR hooks (with the
+** number of uint64_t words they use in CUID_RANDOM_SNAPSHOT_WORDS) and the
+** counter defines CUID_RESTORE_COUNTER_PTR.
+**
+** PCG32 (CUID_RANDOM_PCG32) is the backend for compact snapshots: 49 bytes,
+** restored in constant time. The default MWC is filled by the system random
+** and its snapshot holds its whole state, about 64KB for the two generators,
+** restored in constant time. With CUID_MWC_SEEDED the snapshot of MWC is its
+** seed and position, 57 bytes, restored in O(position).
+*/
+#if defined(CUID_SNAPSHOT_RANDOM_PTR) && defined(CUID_RESTORE_RANDOM_PTR) \
+  && defined(CUID_RESTORE_COUNTER_PTR)
+#define CUID_SNAPSHOT_VERSION 3
+#ifdef CUID_PEEK_RANDOM_PTR
+#define CUID_SNAPSHOT_RANDOMS 1
+#else
+#define CUID_SNAPSHOT_RANDOMS 2
+#endif /* CUID_PEEK_RANDOM_PTR */
+#define CUID_SNAPSHOT_SIZE \
+  (1 + CUID_SNAPSHOT_RANDOMS * CUID_RANDOM_SNAPSHOT_WORDS * 8 + 8 + 8 + 4 \
+   + CUID_BLOCK_LENGTH)
+
+/*
+** Writes the snapshot of the `cuid_t` pointed by `id` into `snapshot`.
+** Returns the number of bytes written, CUID_SNAPSHOT_SIZE.
+*/
+static inline size_t
+cuid_snapshot(cuid_t const *id,
+              uint8_t snapshot[CUID_STATIC CUID_SNAPSHOT_SIZE]) {
+#ifdef CUID_PEEK_RANDOM_PTR
+  CUID_RANDOM_T const *randoms[CUID_SNAPSHOT_RANDOMS] = { &id->cuid_rnd };
+#else
+  CUID_RANDOM_T const *randoms[CUID_SNAPSHOT_RANDOMS] = {
+    &id->cuid_rnd1, &id->cuid_rnd2
+  };
+#endif /* CUID_PEEK_RANDOM_PTR */
+  size_t length = 0;
+  snapshot[length++] = CUID_SNAPSHOT_VERSION;
+  for (size_t r = 0; r < CUID_SNAPSHOT_RANDOMS; ++r) {
+    uint64_t words[CUID_RANDOM_SNAPSHOT_WORDS];
+    CUID_SNAPSHOT_RANDOM_PTR(randoms[r], words);
+    for (size_t w = 0; w < CUID_RANDOM_SNAPSHOT_WORDS; ++w) {
+      cuid_bin_store(&snapshot[length], words[w], 8);
+      length += 8;
+    }
+  }
+  cuid_bin_store(&snapshot[length], CUID_READ_COUNTER_PTR(&id->cuid_counter),
+                 8);
+  length += 8;
+  cuid_bin_store(&snapshot[length], id->cuid_timestamp_value, 8);
+  length += 8;
+  cuid_bin_store(&snapshot[length], id->cuid_tick_count, 4);
+  length += 4;
+  for (size_t i = 0; i < CUID_BLOCK_LENGTH; ++i) {
+    snapshot[length++] = (uint8_t)id->cuid_value[CUID_FINGERPRINT_OFFSET + i];
+  }
+  return length;
+}
+
+/*
+** Restores the `cuid_t` pointed by `id` from a snapshot made by
+** `cuid_snapshot`. The restored state makes the same cuids as the state the
+** snapshot was made from, and its current cuid can be read right away.
+**
+** Returns 1 on success, 0 if the snapshot has another version or is not
+** valid, in which case `id` should not be used.
+*/
+static inline int
+cuid_restore(cuid_t *id,
+             uint8_t const snapshot[CUID_STATIC CUID_SNAPSHOT_SIZE]) {
+  if (snapshot[0] != CUID_SNAPSHOT_VERSION) {
+    return 0;
+  }
+#ifdef CUID_PEEK_RANDOM_PTR
+  CUID_RANDOM_T *randoms[CUID_SNAPSHOT_RANDOMS] = { &id->cuid_rnd };
+#else
+  CUID_RANDOM_T *randoms[CUID_SNAPSHOT_RANDOMS] = {
+    &id->cuid_rnd1, &id->cuid_rnd2
+  };
+#endif /* CUID_PEEK_RANDOM_PTR */
+  size_t length = 1;
+  for (size_t r = 0; r < CUID_SNAPSHOT_RANDOMS; ++r) {
+    uint64_t words[CUID_RANDOM_SNAPSHOT_WORDS];
+    for (size_t w = 0; w < CUID_RANDOM_SNAPSHOT_WORDS; ++w) {
+      words[w] = cuid_bin_load(&snapshot[length], 8);
+      length += 8;
+    }
+    if (!CUID_RESTORE_RANDOM_PTR(randoms[r], words)) {
+      return 0;
+    }
+  }
+  CUID_RESTORE_COUNTER_PTR(&id->cuid_counter,
+                           cuid_bin_load(&snapshot[length], 8));
+  length += 8;
+  uint64_t const timestamp = cuid_bin_load(&snapshot[length], 8);
+  length += 8;
+  id->cuid_tick_count = (uint32_t)cuid_bin_load(&snapshot[length], 4);
+  length += 4;
+  for (size_t i = 0; i < CUID_SIZE; ++i) {
+    id->cuid_value[i] = '\0';
+  }
+  id->cuid_value[0] = 'c';
+  for (size_t i = 0; i < CUID_BLOCK_LENGTH; ++i) {
+    id->cuid_value[CUID_FINGERPRINT_OFFSET + i] = (char)snapshot[length++];
+  }
+  id->cuid_timestamp_value = (unsigned long)timestamp;
+  if (id->cuid_timestamp_value != ULONG_MAX) {
+    cuid_base36_timestamp(timestamp, &id->cuid_value[CUID_TIMESTAMP_OFFSET]);
+  }
+#ifdef CUID_STATS
+  // The counters are not in the snapshot, they start again
+  cuid_stats_t const no_stats = {0, 0, 0, 0, 0};
+  id->cuid_stats = no_stats;
+#endif /* CUID_STATS */
+#ifdef CUID_FORK_SAFE
+  CUID_FORK_EPOCH_WATCH();
+  id->cuid_fork_epoch = CUID_FORK_EPOCH();
+#endif /* CUID_FORK_SAFE */
+#ifndef CUID_LAZY
+  cuid_gen_value_string_inplace(id);
+#endif /* CUID_LAZY */
+  return 1;
+}
+#endif /* CUID_SNAPSHOT_RANDOM_PTR */
+
+/*
+** Advances the cuid_t pointed by `id` like `cuid_next_inplace`, unless its
+** counter would wrap around within the same timestamp: CUID_COUNTER_MAX
+** cuids were already made with that timestamp, by this function or by
+** `cuid_next_inplace`, `cuid_skip_inplace` and `cuid_generate_stride`.
+**
+** Returns 1 if a new cuid was generated, 0 if the counter would wrap, in
+** which case `id` is left untouched and the caller can wait for a newer
+** timestamp or accept the wrap with `cuid_next_inplace`.
+**
+** With CUID_ORDERED the counter never wraps within a timestamp, a full
+** timestamp moves on to the next millisecond, so this always returns 1.
+*/
+static inline int
+cuid_next_checked(cuid_t *id, unsigned long const timestamp) {
+#ifdef CUID_ORDERED
+  cuid_next_inplace(id, timestamp);
+  return 1;
+#else
+  uint32_t const count =
+    timestamp == id->cuid_timestamp_value ? id->cuid_tick_count : 0;
+  if (count >= CUID_COUNTER_MAX) {
+    return 0;
+  }
+  cuid_next_inplace(id, timestamp);
+  return 1;
+#endif /* CUID_ORDERED */
+}
+
+/*
+** Generates `n` cuids in a row into the `out` buffer, placing each one
+** `stride` chars after the previous one.
+**
+** This is the same as calling `cuid_next_inplace(id, timestamp)` followed by
+** `cuid_read_ptr` `n` times, but the timestamp and fingerprint blocks are
+** only set once for the whole batch (with CUID_ORDERED the timestamp is
+** checked for each cuid) and the counter is kept in a local variable while
+** generating. The random numbers of each chunk of
+** CUID_BATCH_CHUNK cuids are made in a block by CUID_FILL_RANDOM_PTR, and
+** the counter and random blocks are formatted with `cuid_base36_blocks`.
+**
+** Each cuid takes `CUID_SIZE - 1` chars. When `stride` is at least
+** `CUID_SIZE` each cuid is '\0' terminated, with a `stride` of
+** `CUID_SIZE - 1` the cuids are packed together without terminators.
+**
+** After this call the `id` holds the state of the last cuid generated.
+*/
+static inline void
+cuid_generate_stride(cuid_t *id,
+                     unsigned long const timestamp,
+                     size_t const n,
+                     size_t const stride,
+                     char *out) {
+  if (n == 0) {
+    return;
+  }
+  CUID_TRACE_BEGIN("cuid_generate_stride");
+  cuid_check_fork_inplace(id);
+#ifndef CUID_ORDERED
+  cuid_count_ticks_inplace(id, timestamp, n);
+  cuid_set_timestamp_inplace(id, timestamp);
+#endif /* CUID_ORDERED */
+  CUID_COUNTER_T counter = id->cuid_counter;
+  // The numbers of each chunk, formatted together by `cuid_base36_blocks`
+  uint32_t counters[CUID_BATCH_CHUNK];
+  uint32_t rnds1[CUID_BATCH_CHUNK];
+  uint32_t rnds2[CUID_BATCH_CHUNK];
+  for (size_t start = 0; start < n; start += CUID_BATCH_CHUNK) {
+    size_t const chunk_size = n - start < CUID_BATCH_CHUNK ?
+                              n - start : CUID_BATCH_CHUNK;
+    char *chunk = &out[start * stride];
+    for (size_t n_i = 0; n_i < chunk_size; ++n_i) {
+      char *result = &chunk[n_i * stride];
+#ifdef CUID_ORDERED
+      cuid_set_timestamp_inplace(id,
+        cuid_ordered_advance_inplace(id, &counter, timestamp));
+#else
+      cuid_increase_counter_inplace(id, &counter);
+#endif /* CUID_ORDERED */
+      counters[n_i] = CUID_READ_COUNTER_PTR(&counter);
+      // Letter and timestamp
+      result[0] = 'c';
+      for (size_t i = 0; i < CUID_TIMESTAMP_LENGTH; ++i) {
+        result[CUID_TIMESTAMP_OFFSET + i] =
+          id->cuid_value[CUID_TIMESTAMP_OFFSET + i];
+      }
+      // Fingerprint
+      for (size_t i = 0; i < CUID_BLOCK_LENGTH; ++i) {
+        result[CUID_FINGERPRINT_OFFSET + i] =
+          id->cuid_value[CUID_FINGERPRINT_OFFSET + i];
+      }
+      if (stride >= CUID_SIZE) {
+        result[CUID_SIZE - 1] = '\0';
+      }
+    }
+    // Counter and random blocks
+    cuid_fill_randoms_inplace(id, chunk_size, rnds1, rnds2);
+    cuid_base36_blocks(counters, chunk_size, &chunk[CUID_COUNTER_OFFSET],
+                       stride);
+    cuid_base36_blocks(rnds1, chunk_size, &chunk[CUID_RANDOM1_OFFSET], stride);
+    cuid_base36_blocks(rnds2, chunk_size, &chunk[CUID_RANDOM2_OFFSET], stride);
+  }
+  id->cuid_counter = counter;
+  // Keep the last cuid as the value of the state
+  char const *last = &out[(n - 1) * stride];
+  for (size_t i = 0; i < CUID_SIZE - 1; ++i) {
+    id->cuid_value[i] = last[i];
+  }
+  id->cuid_value[CUID_SIZE - 1] = '\0';
+  CUID_STATS_ADD(&id->cuid_stats, cuid_generated, n);
+  CUID_TRACE_END("cuid_generate_stride");
+}
+
+/*
+** Generates `n` '\0' terminated cuids into the `out` array.
+** See `cuid_generate_stride`.
+*/
+static inline void
+cuid_generate_n(cuid_t *id,
+                unsigned long const timestamp,
+                size_t const n,
+                char out[][CUID_SIZE]) {
+  cuid_generate_stride(id, timestamp, n, CUID_SIZE, out[0]);
+}
+
+/*-- MARK: Shared generator --------------------------------------------------*/
+/*
+** A generator that many threads can use at the same time, without a mutex,
+** and whose cuids are ordered across all of its threads.
+**
+** The timestamp and the counter are kept together in a single atomic 64 bit
+** word, the timestamp in the high CUID_SHARED_TIMESTAMP_BITS and the counter
+** in the low CUID_SHARED_COUNTER_BITS. Each cuid takes its timestamp and
+** counter from one atomic fetch-add on that word, so no two cuids get the
+** same pair and their order matches the order of the fetch-adds. A newer
+** timestamp is stored with a compare-exchange that starts the counter again
+** at 0, the timestamp never goes back. When the counter of a timestamp
+** reaches CUID_COUNTER_MAX (36^4, what fits in its block) the generator
+** moves on to the next timestamp (the next second, or millisecond with
+** CUID_ORDERED) with a compare-exchange, before the counter could carry into
+** the timestamp bits. So the cuids are always strictly increasing.
+**
+** The encoded timestamp block is cached in a seqlock so that it is only
+** encoded again when the timestamp changes. The random blocks come from a
+** PCG32 generator in thread local storage, seeded on the first use in each
+** thread.
+**
+** Only available if CUID_THREADS is defined.
+*/
+#ifdef CUID_THREADS
+#include <string.h> // memcpy
+
+#ifndef CUID_SHARED_COUNTER_BITS
+#ifdef CUID_ORDERED
+#define CUID_SHARED_COUNTER_BITS 21
+#else
+#define CUID_SHARED_COUNTER_BITS 24
+#endif /* CUID_ORDERED */
+#endif /* CUID_SHARED_COUNTER_BITS */
+#if (1ULL << CUID_SHARED_COUNTER_BITS) <= CUID_COUNTER_MAX
+#error "CUID_SHARED_COUNTER_BITS must hold more than CUID_COUNTER_MAX values"
+#endif
+#define CUID_SHARED_TIMESTAMP_BITS (64 - CUID_SHARED_COUNTER_BITS)
+typedef struct cuid_shared_t {
+  // The timestamp and the counter, see above
+  CUID_ATOMIC(uint64_t) cuid_state;
+  // Even when the cached timestamp block can be read, odd while it is written
+  CUID_ATOMIC(uint32_t) cuid_sequence;
+  CUID_ATOMIC(uint64_t) cuid_timestamp_value;
+  // The chars of the timestamp block
+  CUID_ATOMIC(uint64_t) cuid_timestamp_block;
+  char cuid_fingerprint[CUID_FINGERPRINT_SIZE];
+} cuid_shared_t;
+
+// The random number generator of each thread, seeded when `pcg_inc` is 0
+static CUID_THREAD_LOCAL cuid_pcg32_t cuid_shared_random = {0, 0, 0};
+#ifdef CUID_FORK_SAFE
+static CUID_THREAD_LOCAL uint32_t cuid_shared_random_epoch = 0;
+#endif /* CUID_FORK_SAFE */
+
+/*
+** Initializes a shared generator with the provided fingerprint.
+** This must be done before the generator is used from other threads.
+*/
+static inline void
+cuid_shared_init(cuid_shared_t *shared,
+                 char const fingerprint[CUID_STATIC CUID_FINGERPRINT_SIZE]) {
+  atomic_store_explicit(&shared->cuid_state, 0, memory_order_relaxed);
+  atomic_store_explicit(&shared->cuid_sequence, 0, memory_order_relaxed);
+  // No timestamp is cached until the first one is encoded
+  atomic_store_explicit(&shared->cuid_timestamp_value, UINT64_MAX,
+                        memory_order_relaxed);
+  atomic_store_explicit(&shared->cuid_timestamp_block, 0,
+                        memory_order_relaxed);
+  memcpy(shared->cuid_fingerprint, fingerprint, CUID_FINGERPRINT_SIZE - 1);
+  shared->cuid_fingerprint[CUID_FINGERPRINT_SIZE - 1] = '\0';
+}
+
+/*
+** Reads the cached timestamp block into `block` if it is the block of
+** `timestamp`. Returns 1 if it was read, 0 otherwise.
+*/
+static inline int
+cuid_shared_read_timestamp(cuid_shared_t *shared,
+                           uint64_t const timestamp,
+                           char block[CUID_STATIC CUID_TIMESTAMP_LENGTH]) {
+  uint32_t const sequence =
+    atomic_load_explicit(&shared->cuid_sequence, memory_order_acquire);
+  if (sequence & 1U) {
+    return 0;
+  }
+  uint64_t const value = atomic_load_explicit(&shared->cuid_timestamp_value,
+                                              memory_order_relaxed);
+  uint64_t const packed = atomic_load_explicit(&shared->cuid_timestamp_block,
+                                               memory_order_relaxed);
+  atomic_thread_fence(memory_order_acquire);
+  if (atomic_load_explicit(&shared->cuid_sequence, memory_order_relaxed)
+      != sequence || value != timestamp) {
+    return 0;
+  }
+  memcpy(block, &packed, CUID_TIMESTAMP_LENGTH);
+  return 1;
+}
+
+/*
+** Stores a newer timestamp block in the cache, unless another thread is
+** already writing it.
+*/
+static inline void
+cuid_shared_write_timestamp(cuid_shared_t *shared,
+                            uint64_t const timestamp,
+                            char const
+                              block[CUID_STATIC CUID_TIMESTAMP_LENGTH]) {
+  uint32_t sequence =
+    atomic_load_explicit(&shared->cuid_sequence, memory_order_relaxed);
+  if ((sequence & 1U) || !atomic_compare_exchange_strong_explicit(
+        &shared->cuid_sequence, &sequence, sequence + 1,
+        memory_order_relaxed, memory_order_relaxed)) {
+    return;
+  }
+  atomic_thread_fence(memory_order_release);
+  uint64_t const cached = atomic_load_explicit(&shared->cuid_timestamp_value,
+                                               memory_order_relaxed);
+  if (cached == UINT64_MAX || cached < timestamp) {
+    uint64_t packed = 0;
+    memcpy(&packed, block, CUID_TIMESTAMP_LENGTH);
+    atomic_store_explicit(&shared->cuid_timestamp_value, timestamp,
+                          memory_order_relaxed);
+    atomic_store_explicit(&shared->cuid_timestamp_block, packed,
+                          memory_order_relaxed);
+  }
+  atomic_store_explicit(&shared->cuid_sequence, sequence + 2,
+                        memory_order_release);
+}
+
+/*
+** Generates the next cuid of a shared generator into `result`.
+** Can be called concurrently from any number of threads.
+** Returns the length of the cuid string.
+*/
+static inline size_t
+cuid_shared_next(cuid_shared_t *shared,
+                 unsigned long const timestamp,
+                 char result[CUID_STATIC CUID_SIZE]) {
+  uint64_t const wanted = (uint64_t)timestamp
+    & ((1ULL << CUID_SHARED_TIMESTAMP_BITS) - 1);
+  uint64_t state = atomic_load_explicit(&shared->cuid_state,
+                                        memory_order_relaxed);
+  while ((state >> CUID_SHARED_COUNTER_BITS) < wanted) {
+    uint64_t const newer = wanted << CUID_SHARED_COUNTER_BITS;
+    if (atomic_compare_exchange_weak_explicit(&shared->cuid_state, &state,
+          newer, memory_order_relaxed, memory_order_relaxed)) {
+      break;
+    }
+  }
+  state = atomic_fetch_add_explicit(&shared->cuid_state, 1,
+                                    memory_order_relaxed);
+  // A full counter moves the state on to the next timestamp
+  while ((state & ((1ULL << CUID_SHARED_COUNTER_BITS) - 1))
+         >= CUID_COUNTER_MAX) {
+    uint64_t const tick = state >> CUID_SHARED_COUNTER_BITS;
+    uint64_t current = atomic_load_explicit(&shared->cuid_state,
+                                            memory_order_relaxed);
+    while ((current >> CUID_SHARED_COUNTER_BITS) == tick
+           && !atomic_compare_exchange_weak_explicit(&shared->cuid_state,
+                 &current, (tick + 1) << CUID_SHARED_COUNTER_BITS,
+                 memory_order_relaxed, memory_order_relaxed)) {
+    }
+    state = atomic_fetch_add_explicit(&shared->cuid_state, 1,
+                                      memory_order_relaxed);
+  }
+  uint64_t const state_timestamp = state >> CUID_SHARED_COUNTER_BITS;
+
+  result[0] = 'c';
+  if (!cuid_shared_read_timestamp(shared, state_timestamp, &result[1])) {
+    cuid_base36_timestamp(state_timestamp, &result[1]);
+    cuid_shared_write_timestamp(shared, state_timestamp, &result[1]);
+  }
+  char *block = &result[CUID_COUNTER_OFFSET];
+  uint64_t const counter = state & ((1ULL << CUID_SHARED_COUNTER_BITS) - 1);
+  cuid_base36_block((uint32_t)counter, &block[0]);
+  memcpy(&block[4], shared->cuid_fingerprint, 4);
+
+#ifdef CUID_FORK_SAFE
+  // A child does not reuse the random numbers of its parent
+  if (cuid_shared_random_epoch != CUID_FORK_EPOCH()) {
+    cuid_shared_random.pcg_inc = 0;
+  }
+#endif /* CUID_FORK_SAFE */
+  if (cuid_shared_random.pcg_inc == 0) {
+    CUID_FORK_EPOCH_WATCH();
+    cuid_pcg32_create_ptr(&cuid_shared_random);
+#ifdef CUID_FORK_SAFE
+    cuid_shared_random_epoch = CUID_FORK_EPOCH();
+#endif /* CUID_FORK_SAFE */
+  }
+  cuid_pcg32_next_ptr(&cuid_shared_random);
+  cuid_base36_block(cuid_pcg32_read_ptr(&cuid_shared_random), &block[8]);
+  cuid_pcg32_next_ptr(&cuid_shared_random);
+  cuid_base36_block(cuid_pcg32_read_ptr(&cuid_shared_random), &block[12]);
+  result[CUID_SIZE - 1] = '\0';
+  return CUID_SIZE - 1;
+}
+
+/*-- MARK: Pool --------------------------------------------------------------*/
+/*
+** A pool of ready made cuids, so that getting a cuid on a latency critical
+** path is just taking it out of a ring buffer.
+**
+** The ring is a bounded MPMC queue (D. Vyukov's design): each slot has a
+** sequence number that tells if it holds a cuid for the current lap, so
+** consumers pop with a single compare-exchange on the ring position and
+** any number of threads can call `cuid_pool_pop` at the same time.
+**
+** The slots are provided by the caller, their count must be a power of 2.
+** The pool is filled by `cuid_pool_refill`, which must only be called from
+** one thread at a time since it advances the pool cuid_t. Either call it
+** from the consumers when `cuid_pool_size` drops to the low watermark, or
+** call `cuid_pool_start` to have a background thread refill the pool each
+** time it drops to its low watermark.
+**
+** Note that the cuids are made ahead of time, their timestamp is the one at
+** which they were generated and not the one at which they are popped.
+*/
+#include <pthread.h> // pthread_create, pthread_cond_timedwait
+
+typedef struct cuid_pool_slot_t {
+  CUID_ATOMIC(size_t) cuid_sequence;
+  char cuid_value[CUID_SIZE];
+} cuid_pool_slot_t;
+
+typedef struct cuid_pool_t {
+  cuid_pool_slot_t *cuid_slots;
+  // The number of slots minus 1
+  size_t cuid_mask;
+  size_t cuid_low_watermark;
+  // The positions of the next slot to push and to pop
+  CUID_ATOMIC(size_t) cuid_push;
+  CUID_ATOMIC(size_t) cuid_pop;
+  // The generator of the cuids, only used by the refilling thread
+  cuid_t cuid_id;
+  // The background producer, see `cuid_pool_start`
+  CUID_ATOMIC(int) cuid_running;
+  pthread_t cuid_producer;
+  pthread_mutex_t cuid_mutex;
+  pthread_cond_t cuid_low;
+} cuid_pool_t;
+
+/*
+** Initializes a pool with the `capacity` slots provided, its cuids use the
+** provided fingerprint. The pool is refilled when it holds `low_watermark`
+** or fewer cuids.
+** Returns 1 on success, 0 if `capacity` is not a power of 2 or
+** `low_watermark` is not less than `capacity`. The pool starts empty.
+*/
+static inline int
+cuid_pool_init(cuid_pool_t *pool,
+               cuid_pool_slot_t *slots,
+               size_t const capacity,
+               size_t const low_watermark,
+               char const fingerprint[CUID_STATIC CUID_FINGERPRINT_SIZE]) {
+  if (capacity == 0 || (capacity & (capacity - 1)) != 0
+      || low_watermark >= capacity) {
+    return 0;
+  }
+  for (size_t i = 0; i < capacity; ++i) {
+    atomic_store_explicit(&slots[i].cuid_sequence, i, memory_order_relaxed);
+  }
+  pool->cuid_slots = slots;
+  pool->cuid_mask = capacity - 1;
+  pool->cuid_low_watermark = low_watermark;
+  atomic_store_explicit(&pool->cuid_push, 0, memory_order_relaxed);
+  atomic_store_explicit(&pool->cuid_pop, 0, memory_order_relaxed);
+  cuid_create_inplace(&pool->cuid_id, fingerprint);
+  cuid_init_inplace(&pool->cuid_id, CUID_GET_TIMESTAMP());
+  atomic_store_explicit(&pool->cuid_running, 0, memory_order_relaxed);
+  pthread_mutex_init(&pool->cuid_mutex, 0x0);
+  pthread_cond_init(&pool->cuid_low, 0x0);
+  return 1;
+}
+
+/*
+** Returns the number of cuids in the pool. This is only an estimate while
+** other threads use the pool.
+*/
+static inline size_t
+cuid_pool_size(cuid_pool_t *pool) {
+  size_t const pop = atomic_load_explicit(&pool->cuid_pop,
+                                          memory_order_relaxed);
+  size_t const push = atomic_load_explicit(&pool->cuid_push,
+                                           memory_order_relaxed);
+  return push - pop <= pool->cuid_mask + 1 ? push - pop : 0;
+}
+
+/*
+** Fills the free slots of the pool with new cuids made with `timestamp`.
+** Must only be called from one thread at a time.
+** Returns the number of cuids added.
+*/
+static inline size_t
+cuid_pool_refill(cuid_pool_t *pool, unsigned long const timestamp) {
+  size_t added = 0;
+  size_t push = atomic_load_explicit(&pool->cuid_push, memory_order_relaxed);
+  for (;;) {
+    cuid_pool_slot_t *slot = &pool->cuid_slots[push & pool->cuid_mask];
+    size_t const sequence = atomic_load_explicit(&slot->cuid_sequence,
+                                                 memory_order_acquire);
+    if (sequence != push) {
+      // The slot was not popped yet, the pool is full
+      break;
+    }
+    cuid_next_inplace(&pool->cuid_id, timestamp);
+    cuid_read_ptr(&pool->cuid_id, slot->cuid_value);
+    push++;
+    atomic_store_explicit(&pool->cuid_push, push, memory_order_relaxed);
+    atomic_store_explicit(&slot->cuid_sequence, push, memory_order_release);
+    added++;
+  }
+  return added;
+}
+
+/*
+** Takes a cuid out of the pool into `result`.
+** Can be called concurrently from any number of threads.
+** Returns 1 if a cuid was placed in `result`, 0 if the pool is empty.
+*/
+static inline int
+cuid_pool_pop(cuid_pool_t *pool, char result[CUID_STATIC CUID_SIZE]) {
+  size_t pop = atomic_load_explicit(&pool->cuid_pop, memory_order_relaxed);
+  for (;;) {
+    cuid_pool_slot_t *slot = &pool->cuid_slots[pop & pool->cuid_mask];
+    size_t const sequence = atomic_load_explicit(&slot->cuid_sequence,
+                                                 memory_order_acquire);
+    ptrdiff_t const lap = (ptrdiff_t)(sequence - (pop + 1));
+    if (lap == 0) {
+      if (atomic_compare_exchange_weak_explicit(&pool->cuid_pop, &pop,
+            pop + 1, memory_order_relaxed, memory_order_relaxed)) {
+        memcpy(result, slot->cuid_value, CUID_SIZE);
+        // The slot is free for the next lap
+        atomic_store_explicit(&slot->cuid_sequence, pop + pool->cuid_mask + 1,
+                              memory_order_release);
+        break;
+      }
+    } else if (lap < 0) {
+      // Not pushed yet, the pool is empty
+      if (atomic_load_explicit(&pool->cuid_running, memory_order_relaxed)) {
+        pthread_cond_signal(&pool->cuid_low);
+      }
+      return 0;
+    } else {
+      pop = atomic_load_explicit(&pool->cuid_pop, memory_order_relaxed);
+    }
+  }
+  // Wake up the producer when the pool drops to its low watermark
+  if (atomic_load_explicit(&pool->cuid_running, memory_order_relaxed)
+      && cuid_pool_size(pool) <= pool->cuid_low_watermark) {
+    pthread_cond_signal(&pool->cuid_low);
+  }
+  return 1;
+}
+
+/*
+** The background producer, refills the pool and waits for it to drop to its
+** low watermark. A wake up can be missed since the consumers do not take the
+** mutex, so the wait also times out every millisecond.
+*/
+static inline void *
+cuid_pool_producer(void *arg) {
+  cuid_pool_t *pool = (cuid_pool_t *)arg;
+  while (atomic_load_explicit(&pool->cuid_running, memory_order_acquire)) {
+    cuid_pool_refill(pool, CUID_GET_TIMESTAMP());
+    pthread_mutex_lock(&pool->cuid_mutex);
+    while (atomic_load_explicit(&pool->cuid_running, memory_order_acquire)
+           && cuid_pool_size(pool) > pool->cuid_low_watermark) {
+      struct timespec deadline = {0, 0};
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      deadline.tv_nsec += 1000000;
+      if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+      }
+      pthread_cond_timedwait(&pool->cuid_low, &pool->cuid_mutex, &deadline);
+    }
+    pthread_mutex_unlock(&pool->cuid_mutex);
+  }
+  return 0x0;
+}
+
+/*
+** Starts a background thread that keeps the pool filled, the pool must not
+** be refilled by any other thread until `cuid_pool_stop` is called.
+** Returns 1 if the thread was started, 0 otherwise.
+*/
+static inline int
+cuid_pool_start(cuid_pool_t *pool) {
+  atomic_store_explicit(&pool->cuid_running, 1, memory_order_release);
+  if (pthread_create(&pool->cuid_producer, 0x0, cuid_pool_producer, pool)
+      != 0) {
+    atomic_store_explicit(&pool->cuid_running, 0, memory_order_release);
+    return 0;
+  }
+  return 1;
+}
+
+/*
+** Stops the background thread started with `cuid_pool_start` and waits for
+** it to finish. The cuids left in the pool can still be popped. Does nothing
+** if the pool was not started.
+*/
+static inline void
+cuid_pool_stop(cuid_pool_t *pool) {
+  pthread_mutex_lock(&pool->cuid_mutex);
+  int const started = atomic_exchange_explicit(&pool->cuid_running, 0,
+                                               memory_order_acq_rel);
+  pthread_cond_signal(&pool->cuid_low);
+  pthread_mutex_unlock(&pool->cuid_mutex);
+  if (started) {
+    pthread_join(pool->cuid_producer, 0x0);
+  }
+}
+
+/*
+** Releases the resources of a pool, after `cuid_pool_stop` if it was
+** started. The slots belong to the caller.
+*/
+static inline void
+cuid_pool_destroy(cuid_pool_t *pool) {
+  pthread_cond_destroy(&pool->cuid_low);
+  pthread_mutex_destroy(&pool->cuid_mutex);
+}
+#endif /* CUID_THREADS */
+
+/*-- MARK: Writer ------------------------------------------------------------*/
+/*
+** A writer that streams delimited cuids, one per line or as CSV values,
+** straight into an output buffer that is handed to a sink when it is full.
+**
+** The cuids are formatted by `cuid_generate_stride` with a stride of
+** CUID_SIZE, and the '\0' that ends each one is replaced by the delimiter,
+** so each cuid takes CUID_SIZE bytes of output and is never split between
+** two flushes.
+**
+** The caller provides the buffer, the writer splits it in two halves. With
+** CUID_THREADS, `cuid_writer_start` runs the sink in a background thread:
+** one half is filled with cuids while the other one is being written, and
+** the formatting only waits for the sink when both halves are full.
+** Without it the full half is written by the thread that filled it.
+**
+** A sink receives the chunks to write as an array of `struct iovec`, to
+** write them with `writev` or to copy them anywhere else, and returns 1 if
+** all of the chunks were written and 0 otherwise. `cuid_fd_sink` writes
+** them to the file descriptor pointed by its context.
+**
+** Only available if CUID_WRITER is defined, it needs the POSIX `writev`.
+*/
+#ifdef CUID_WRITER
+#include <errno.h> // errno, EINTR
+#include <sys/uio.h> // writev, struct iovec
+#include <unistd.h> // write
+
+typedef int (*cuid_sink_fn)(void *context,
+                            struct iovec const *chunks,
+                            int const count);
+
+typedef struct cuid_writer_t {
+  // The two halves of the buffer and the bytes each one can take, this is
+  // a multiple of CUID_SIZE
+  char *cuid_buffers[2];
+  size_t cuid_capacity;
+  // The half being filled and its bytes in use
+  int cuid_current;
+  size_t cuid_length;
+  char cuid_delimiter;
+  cuid_sink_fn cuid_sink;
+  void *cuid_context;
+  // Set when the sink fails, nothing else is written after it
+  int cuid_failed;
+  // The generator of the cuids, only used by the filling thread
+  cuid_t cuid_id;
+#ifdef CUID_THREADS
+  // The background flusher, see `cuid_writer_start`. The half it writes
+  // and its length, 0 when there is nothing to write, are guarded by the
+  // mutex.
+  int cuid_running;
+  int cuid_pending_buffer;
+  size_t cuid_pending;
+  pthread_t cuid_flusher;
+  pthread_mutex_t cuid_mutex;
+  pthread_cond_t cuid_ready;
+  pthread_cond_t cuid_done;
+#endif /* CUID_THREADS */
+} cuid_writer_t;
+
+/*
+** A sink that writes the chunks with `writev` to the file descriptor that
+** `context` points to. Partial writes are resumed until all of the chunks
+** are written.
+** Returns 1 on success, 0 if a write failed (errno tells why).
+*/
+static inline int
+cuid_fd_sink(void *context, struct iovec const *chunks, int const count) {
+  int const fd = *(int const *)context;
+  int chunk = 0;
+  size_t offset = 0;
+  while (chunk < count) {
+    ssize_t written;
+    if (offset == 0) {
+      written = writev(fd, &chunks[chunk], count - chunk);
+    } else {
+      // Resume a chunk that was partially written
+      written = write(fd, (char const *)chunks[chunk].iov_base + offset,
+                      chunks[chunk].iov_len - offset);
+    }
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return 0;
+    }
+    size_t left = (size_t)written;
+    while (chunk < count && left >= chunks[chunk].iov_len - offset) {
+      left -= chunks[chunk].iov_len - offset;
+      offset = 0;
+      chunk++;
+    }
+    offset += left;
+  }
+  return 1;
+}
+
+/*
+** Initializes a writer of cuids with the provided fingerprint, separated by
+** `delimiter` and written to `sink` with its `context`. The `buffer` of
+** `capacity` bytes belongs to the caller and must outlive the writer.
+** Returns 1 on success, 0 if the buffer can not take two cuids.
+*/
+static inline int
+cuid_writer_init(cuid_writer_t *writer,
+                 char *buffer,
+                 size_t const capacity,
+                 char const delimiter,
+                 cuid_sink_fn sink,
+                 void *context,
+                 char const fingerprint[CUID_STATIC CUID_FINGERPRINT_SIZE]) {
+  size_t const half = capacity / 2 / CUID_SIZE * CUID_SIZE;
+  if (buffer == 0x0 || half == 0 || sink == 0x0) {
+    return 0;
+  }
+  writer->cuid_buffers[0] = buffer;
+  writer->cuid_buffers[1] = &buffer[half];
+  writer->cuid_capacity = half;
+  writer->cuid_current = 0;
+  writer->cuid_length = 0;
+  writer->cuid_delimiter = delimiter;
+  writer->cuid_sink = sink;
+  writer->cuid_context = context;
+  writer->cuid_failed = 0;
+  cuid_create_inplace(&writer->cuid_id, fingerprint);
+  cuid_init_inplace(&writer->cuid_id, CUID_GET_TIMESTAMP());
+#ifdef CUID_THREADS
+  writer->cuid_running = 0;
+  writer->cuid_pending_buffer = 0;
+  writer->cuid_pending = 0;
+  pthread_mutex_init(&writer->cuid_mutex, 0x0);
+  pthread_cond_init(&writer->cuid_ready, 0x0);
+  pthread_cond_init(&writer->cuid_done, 0x0);
+#endif /* CUID_THREADS */
+  return 1;
+}
+
+/*
+** Hands the half being filled to the sink and starts filling the other one.
+** With a running flusher this only waits for the previous half to be
+** written. Returns 0 if the sink failed, now or for a previous half.
+*/
+static inline int
+cuid_writer_submit(cuid_writer_t *writer) {
+#ifdef CUID_THREADS
+  if (writer->cuid_running) {
+    pthread_mutex_lock(&writer->cuid_mutex);
+    while (writer->cuid_pending != 0) {
+      pthread_cond_wait(&writer->cuid_done, &writer->cuid_mutex);
+    }
+    int const ok = !writer->cuid_failed;
+    if (ok && writer->cuid_length != 0) {
+      writer->cuid_pending_buffer = writer->cuid_current;
+      writer->cuid_pending = writer->cuid_length;
+      pthread_cond_signal(&writer->cuid_ready);
+      writer->cuid_current ^= 1;
+      writer->cuid_length = 0;
+    }
+    pthread_mutex_unlock(&writer->cuid_mutex);
+    return ok;
+  }
+#endif /* CUID_THREADS */
+  if (writer->cuid_failed) {
+    return 0;
+  }
+  if (writer->cuid_length != 0) {
+    struct iovec const chunk = {
+      writer->cuid_buffers[writer->cuid_current], writer->cuid_length
+    };
+    if (!writer->cuid_sink(writer->cuid_context, &chunk, 1)) {
+      writer->cuid_failed = 1;
+      return 0;
+    }
+    writer->cuid_current ^= 1;
+    writer->cuid_length = 0;
+  }
+  return 1;
+}
+
+/*
+** Writes `n` new cuids with the provided timestamp, each one followed by
+** the delimiter. The cuids are formatted into the buffer and the sink only
+** gets them as each half is full, call `cuid_writer_flush` to write them
+** all.
+** Returns the number of cuids written, this is less than `n` only if the
+** sink failed.
+*/
+static inline size_t
+cuid_writer_write_n(cuid_writer_t *writer,
+                    unsigned long const timestamp,
+                    size_t const n) {
+  size_t done = 0;
+  while (done < n) {
+    if (writer->cuid_length == writer->cuid_capacity
+        && !cuid_writer_submit(writer)) {
+      break;
+    }
+    size_t const room = (writer->cuid_capacity - writer->cuid_length)
+                        / CUID_SIZE;
+    size_t const count = n - done < room ? n - done : room;
+    char *out = &writer->cuid_buffers[writer->cuid_current]
+                                     [writer->cuid_length];
+    cuid_generate_stride(&writer->cuid_id, timestamp, count, CUID_SIZE, out);
+    for (size_t i = 0; i < count; ++i) {
+      out[i * CUID_SIZE + CUID_SIZE - 1] = writer->cuid_delimiter;
+    }
+    writer->cuid_length += count * CUID_SIZE;
+    done += count;
+  }
+  return done;
+}
 
 /*
-** Internal function that creates a carry that is guaranteed to be < MWC_C_MAX.
-** This function uses the defined MWC_SYSTEM_RAND32 system random.
+** Writes all of the cuids in the buffer to the sink and waits for them to
+** be written. Returns 1 on success, 0 if the sink failed.
 */
-static inline uint32_t mwc_initial_c(void) {
-  uint32_t mwc_initial_carry = 0;
-
-  do {
-		mwc_initial_carry = MWC_SYSTEM_RAND32();
-  } while (mwc_initial_carry >= MWC_C_MAX);
-
-  return mwc_initial_carry;
+static inline int
+cuid_writer_flush(cuid_writer_t *writer) {
+  int const ok = cuid_writer_submit(writer);
+#ifdef CUID_THREADS
+  if (writer->cuid_running) {
+    pthread_mutex_lock(&writer->cuid_mutex);
+    while (writer->cuid_pending != 0) {
+      pthread_cond_wait(&writer->cuid_done, &writer->cuid_mutex);
+    }
+    int const written = !writer->cuid_failed;
+    pthread_mutex_unlock(&writer->cuid_mutex);
+    return ok && written;
+  }
+#endif /* CUID_THREADS */
+  return ok;
 }
 
+#ifdef CUID_THREADS
 /*
-** Creates a new mwc random state. 
-** Keeps a copy of the initial state to allow `mwc_init()` to
-** be able to reset it to the same initial state, allowing for the 
-** random numbers generation sequence to be replicated again if needed.
+** The background thread of `cuid_writer_start`, writes each half that
+** `cuid_writer_submit` hands to it while the next one is being filled.
 */
-static inline mwc_random_t
-mwc_create() {
-  uint32_t mwc_c = mwc_initial_c();
-  mwc_random_t mwc_state = {
-    .mwc_initial_carry = mwc_c,
-    .mwc_carry = mwc_c,
-    .mwc_current_cycle = MWC_CYCLE -1,
-  };
-
- 	for (size_t i = 0; i < MWC_CYCLE; i++) {
-    mwc_state.mwc_q[i] = MWC_SYSTEM_RAND32();
-    mwc_state.mwc_initial_q[i] = mwc_state.mwc_q[i];
+static inline void *
+cuid_writer_flusher(void *arg) {
+  cuid_writer_t *writer = (cuid_writer_t *)arg;
+  pthread_mutex_lock(&writer->cuid_mutex);
+  for (;;) {
+    while (writer->cuid_pending == 0 && writer->cuid_running) {
+      pthread_cond_wait(&writer->cuid_ready, &writer->cuid_mutex);
+    }
+    if (writer->cuid_pending == 0) {
+      break;
+    }
+    struct iovec const chunk = {
+      writer->cuid_buffers[writer->cuid_pending_buffer], writer->cuid_pending
+    };
+    pthread_mutex_unlock(&writer->cuid_mutex);
+    int const ok = writer->cuid_sink(writer->cuid_context, &chunk, 1);
+    pthread_mutex_lock(&writer->cuid_mutex);
+    if (!ok) {
+      writer->cuid_failed = 1;
+    }
+    writer->cuid_pending = 0;
+    pthread_cond_signal(&writer->cuid_done);
   }
-
-  return mwc_state;
+  pthread_mutex_unlock(&writer->cuid_mutex);
+  return 0x0;
 }
 
-#define CUID_CREATE_RANDOM mwc_create
-
 /*
-** Resets to the initial state.
+** Starts a background thread that runs the sink, so that the buffer can be
+** filled while the previous half is written. The writer must then only be
+** used by one thread until `cuid_writer_stop` is called.
+** Returns 1 if the thread was started, 0 otherwise.
 */
-static inline mwc_random_t
-mwc_init(mwc_random_t r) {
-  r.mwc_carry = r.mwc_initial_carry;
-  r.mwc_current_cycle = MWC_CYCLE -1;
-
- 	for (size_t i = 0; i < MWC_CYCLE; i++) {
-    r.mwc_q[i] = r.mwc_initial_q[i];
+static inline int
+cuid_writer_start(cuid_writer_t *writer) {
+  writer->cuid_running = 1;
+  if (pthread_create(&writer->cuid_flusher, 0x0, cuid_writer_flusher, writer)
+      != 0) {
+    writer->cuid_running = 0;
+    return 0;
   }
-
-  return r;
+  return 1;
 }
 
-#define CUID_INIT_RANDOM mwc_init
-
 /*
-** Returns the random value for the supplied mwc_random_t state.
-** This is a pure function, it always returns the same value for the
-** same input argument.
-**
-** To generate a new random number call `state = mwc_next_random(state)` before
-** calling this method.
+** Flushes the writer and stops the background thread started with
+** `cuid_writer_start`, if it was started. Returns 1 if all of the cuids were
+** written, 0 if the sink failed.
 */
-static inline uint32_t
-mwc_read_random(mwc_random_t const state) {
-  return state.mwc_q[state.mwc_current_cycle];
+static inline int
+cuid_writer_stop(cuid_writer_t *writer) {
+  int const ok = cuid_writer_flush(writer);
+  pthread_mutex_lock(&writer->cuid_mutex);
+  int const started = writer->cuid_running;
+  writer->cuid_running = 0;
+  pthread_cond_signal(&writer->cuid_ready);
+  pthread_mutex_unlock(&writer->cuid_mutex);
+  if (started) {
+    pthread_join(writer->cuid_flusher, 0x0);
+  }
+  return ok;
 }
-
-#define CUID_READ_RANDOM mwc_read_random
+#endif /* CUID_THREADS */
 
 /*
-** This function creates a new random state for the next random number.
-** 
-** To retrieve the random number created, call `mwc_read_random(state)` after
-** this method.
+** Releases the resources of a writer, after `cuid_writer_stop` if it was
+** started. The buffer belongs to the caller, the cuids left in it are not
+** written.
 */
-static inline mwc_random_t
-mwc_next_random(mwc_random_t state) {
-  uint64_t const a = 18782;	// as Marsaglia recommends
-	uint32_t const m = 0xfffffffe;	// as Marsaglia recommends
-	uint64_t t;
-	uint32_t x;
-
-	state.mwc_current_cycle = (state.mwc_current_cycle + 1) & (MWC_CYCLE - 1);
-	t = a * state.mwc_q[state.mwc_current_cycle] + state.mwc_carry;
-	/* Let c = t / 0xffffffff, x = t mod 0xffffffff */
-	state.mwc_carry = t >> 32;
-	x = (uint32_t)t + state.mwc_carry;
-	if (x < state.mwc_carry) {
-		x++;
-		state.mwc_carry++;
-	}
+static inline void
+cuid_writer_destroy(cuid_writer_t *writer) {
+#ifdef CUID_THREADS
+  pthread_cond_destroy(&writer->cuid_done);
+  pthread_cond_destroy(&writer->cuid_ready);
+  pthread_mutex_destroy(&writer->cuid_mutex);
+#else
+  (void)writer;
+#endif /* CUID_THREADS */
+}
+#endif /* CUID_WRITER */
 
-  state.mwc_q[state.mwc_current_cycle] = m - x;
+/*-- MARK: Arena -------------------------------------------------------------*/
+/*
+** A fixed arena of many independent generators, e.g. one per tenant or per
+** shard, that share their fingerprint and are addressed by their index.
+**
+** Each generator is a compact `cuid_arena_slot_t` of 16 bytes (24 with
+** CUID_ORDERED): the state of a PCG32 generator, whose stream increment is
+** derived from the arena and the index, the counter and, with CUID_ORDERED,
+** the timestamp of its previous cuid. The slots are laid out contiguously
+** in a region provided by the caller, so a cuid only touches the cache line
+** of its slot, or in pages mapped by `cuid_arena_map`. The encoded timestamp
+** block is cached per thread, for all of the arenas used in that thread:
+** the block only depends on the timestamp, so the arenas can share it.
+**
+** `cuid_arena_init` writes every slot, which also pre-faults the region.
+** A slot must only be used from one thread at a time, different slots can be
+** used from different threads at the same time.
+**
+** Only available if CUID_ARENA is defined, it needs CUID_THREADS (for its
+** per-thread timestamp cache) and the POSIX `mmap`.
+*/
+#ifdef CUID_ARENA
+#ifndef CUID_THREADS
+#error "CUID_ARENA needs CUID_THREADS for its per-thread timestamp cache"
+#endif /* CUID_THREADS */
+#include <sys/mman.h> // mmap, munmap, madvise
+// Anonymous pages, or else the pages of /dev/zero (e.g. with a strict -std)
+#if defined(MAP_ANONYMOUS)
+#define CUID_MAP_ANONYMOUS MAP_ANONYMOUS
+#elif defined(MAP_ANON)
+#define CUID_MAP_ANONYMOUS MAP_ANON
+#else
+#include <fcntl.h> // open, O_RDWR
+#include <unistd.h> // close
+#endif /* MAP_ANONYMOUS */
 
-  return state;
-}
+typedef struct cuid_arena_slot_t {
+  // The state of the PCG32 generator of the random blocks
+  uint64_t cuid_rnd_state;
+#ifdef CUID_ORDERED
+  // The timestamp of the previous cuid, ULONG_MAX before the first one
+  unsigned long cuid_timestamp_value;
+#endif /* CUID_ORDERED */
+  uint32_t cuid_counter;
+#ifdef CUID_FORK_SAFE
+  // The fork epoch that the slot was seeded in
+  uint32_t cuid_fork_epoch;
+#endif /* CUID_FORK_SAFE */
+} cuid_arena_slot_t;
 
-#define CUID_NEXT_RANDOM mwc_next_random
+typedef struct cuid_arena_t {
+  cuid_arena_slot_t *cuid_slots;
+  size_t cuid_count;
+  // The bytes mapped by `cuid_arena_map`, 0 when the slots are the caller's
+  size_t cuid_mapped_size;
+  // The stream increment of the slot 0, the slot `i` uses `stream + 2 * i`
+  uint64_t cuid_stream;
+  char cuid_fingerprint[CUID_FINGERPRINT_SIZE];
+} cuid_arena_t;
 
-#endif // CUID_RANDOM_T
+// The timestamp block last encoded by this thread for an arena
+static CUID_THREAD_LOCAL unsigned long cuid_arena_timestamp_value = ULONG_MAX;
+static CUID_THREAD_LOCAL char cuid_arena_timestamp_block[CUID_TIMESTAMP_LENGTH];
 
 /*
-** The data type for the state of the cuid pure API.
+** Seeds the PCG32 state of a slot from `seed`, as in the PCG32 reference
+** seeding.
 */
-typedef struct cuid_t {
-  // Fingerprint, limited to 4 chars
-  char cuid_fingerprint[CUID_BASE36_RESULT_SIZE];
-  // Counter, limited to 4 chars
-  CUID_COUNTER_T cuid_counter;
-  // Temporary array to store the base36 string result for the counter
-  char cuid_counter_str[CUID_BASE36_RESULT_SIZE];
-  // Random values, limited to 4 chars, it uses two rng's that get
-  // merged in the final 8 chars of the value.
-  CUID_RANDOM_T cuid_rnd1;
-  CUID_RANDOM_T cuid_rnd2;
-  // Temporary arrays to store the base36 string results for the RNGs
-  char cuid_rnd1_str[CUID_BASE36_RESULT_SIZE];
-  char cuid_rnd2_str[CUID_BASE36_RESULT_SIZE];
-  // The cuid string generated
-  char cuid_value[CUID_SIZE];
-  // The timestamp is limited to 6 chars, it uses a padded base36
-  // string produced from an unsigned long int.
-#define CUID_TIMESTAMP_LENGTH 6
-  char cuid_timestamp[CUID_BASE36_RESULT_SIZE];
-  // Each block of the cuid is made of 4 chars
-#define CUID_BLOCK_LENGTH 4
-} cuid_t;
+static inline void
+cuid_arena_seed_slot(cuid_arena_t const *arena,
+                     size_t const index,
+                     uint64_t *seed) {
+  uint64_t const inc = arena->cuid_stream + 2 * (uint64_t)index;
+  arena->cuid_slots[index].cuid_rnd_state =
+    (inc + cuid_splitmix64(seed)) * CUID_PCG32_MULTIPLIER + inc;
+}
 
 /*
-** Creates a `cuid_t` data type by calling the *_create functions
-** for each of its attributes that need them to be called.
-*/ 
-static inline cuid_t
-cuid_create(char const fingerprint[static CUID_FINGERPRINT_SIZE]) {
-  cuid_t id = {
-    .cuid_counter = CUID_CREATE_COUNTER(),
-    .cuid_rnd1 = CUID_CREATE_RANDOM(),
-    .cuid_rnd2 = CUID_CREATE_RANDOM(),
-  };
-  // Copy the fingerprint from the argument
-  for (size_t i = 0; i < CUID_FINGERPRINT_SIZE; ++i) {
-    id.cuid_fingerprint[i] = fingerprint[i];
+** Initializes an arena of `count` generators in the `slots` provided, its
+** cuids use the provided fingerprint. The slots belong to the caller and
+** must outlive the arena.
+** Returns 1 on success, 0 if `count` is 0.
+*/
+static inline int
+cuid_arena_init(cuid_arena_t *arena,
+                cuid_arena_slot_t *slots,
+                size_t const count,
+                char const fingerprint[CUID_STATIC CUID_FINGERPRINT_SIZE]) {
+  if (count == 0) {
+    return 0;
   }
-  return id;
+  CUID_FORK_EPOCH_WATCH();
+  uint64_t seed = (uint64_t)MWC_SYSTEM_RAND32() << 32 | MWC_SYSTEM_RAND32();
+  arena->cuid_slots = slots;
+  arena->cuid_count = count;
+  arena->cuid_mapped_size = 0;
+  arena->cuid_stream = cuid_splitmix64(&seed) | 1U;
+  memcpy(arena->cuid_fingerprint, fingerprint, CUID_FINGERPRINT_SIZE - 1);
+  arena->cuid_fingerprint[CUID_FINGERPRINT_SIZE - 1] = '\0';
+  for (size_t i = 0; i < count; ++i) {
+    cuid_arena_seed_slot(arena, i, &seed);
+#ifdef CUID_ORDERED
+    slots[i].cuid_timestamp_value = ULONG_MAX;
+#endif /* CUID_ORDERED */
+    slots[i].cuid_counter = 0;
+#ifdef CUID_FORK_SAFE
+    slots[i].cuid_fork_epoch = CUID_FORK_EPOCH();
+#endif /* CUID_FORK_SAFE */
+  }
+  return 1;
 }
 
 /*
-** Internal method that returns a cuid_t with a value string set
-** from its state.
-** This is used to generate a cuid in the value array, ready to be read,
-** at the init and next functions.
+** Initializes an arena of `count` generators in anonymous pages mapped for
+** it, asking for transparent huge pages where `madvise` supports them.
+** Returns 1 on success, 0 if `count` is 0 or the pages could not be mapped,
+** in which case the arena is left without generators. The pages are
+** unmapped by `cuid_arena_destroy`.
 */
-static inline cuid_t
-cuid_gen_value_string(cuid_t id) {
-  // Letter
-  id.cuid_value[0] = 'c';
-  // Timestamp
-  for (size_t i = 0; i < CUID_TIMESTAMP_LENGTH; ++i) {
-    id.cuid_value[1 + i] = id.cuid_timestamp[i];
-  }
-  // Counter
-  cuid_base36_pad(
-      CUID_READ_COUNTER(id.cuid_counter),
-      id.cuid_counter_str,
-      CUID_BLOCK_LENGTH,
-      '0');
-  // Copy the base36 counter string
-  for (size_t i = 0; i < CUID_BLOCK_LENGTH; ++i) {
-    id.cuid_value[i + CUID_TIMESTAMP_LENGTH + 1] = id.cuid_counter_str[i];
+static inline int
+cuid_arena_map(cuid_arena_t *arena,
+               size_t const count,
+               char const fingerprint[CUID_STATIC CUID_FINGERPRINT_SIZE]) {
+  arena->cuid_slots = 0x0;
+  arena->cuid_count = 0;
+  arena->cuid_mapped_size = 0;
+  if (count == 0 || count > SIZE_MAX / sizeof(cuid_arena_slot_t)) {
+    return 0;
   }
-  // Fingerprint (4 chars)
-  for (size_t i = 0; i < CUID_BLOCK_LENGTH; ++i) {
-    id.cuid_value[i + CUID_BLOCK_LENGTH + CUID_TIMESTAMP_LENGTH + 1] =
-      id.cuid_fingerprint[i];
+  size_t const size = count * sizeof(cuid_arena_slot_t);
+#ifdef CUID_MAP_ANONYMOUS
+  void *pages = mmap(0x0, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | CUID_MAP_ANONYMOUS, -1, 0);
+#else
+  int const zero = open("/dev/zero", O_RDWR);
+  if (zero == -1) {
+    return 0;
   }
-  // Random block 1 (4 chars)
-  cuid_base36_pad(
-    CUID_READ_RANDOM(id.cuid_rnd1),
-    id.cuid_rnd1_str,
-    CUID_BLOCK_LENGTH,
-    '0');
-  // Copy the base36 random string
-  for (size_t i = 0; i < CUID_BLOCK_LENGTH; ++i) {
-    id.cuid_value[i + 2*CUID_BLOCK_LENGTH + CUID_TIMESTAMP_LENGTH + 1] =
-      id.cuid_rnd1_str[i];
+  void *pages = mmap(0x0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, zero, 0);
+  close(zero);
+#endif /* CUID_MAP_ANONYMOUS */
+  if (pages == MAP_FAILED) {
+    return 0;
   }
-  // Random block 2 (4 chars)
-  cuid_base36_pad(
-    CUID_READ_RANDOM(id.cuid_rnd2),
-    id.cuid_rnd2_str,
-    CUID_BLOCK_LENGTH,
-    '0');
-  // Copy the base36 random string
-  for (size_t i = 0; i < CUID_BLOCK_LENGTH; ++i) {
-    id.cuid_value[i + 3*CUID_BLOCK_LENGTH + CUID_TIMESTAMP_LENGTH + 1] =
-      id.cuid_rnd2_str[i];
+#ifdef MADV_HUGEPAGE
+  // Only a hint, before the pages are faulted in by `cuid_arena_init`
+  madvise(pages, size, MADV_HUGEPAGE);
+#endif /* MADV_HUGEPAGE */
+  cuid_arena_init(arena, (cuid_arena_slot_t *)pages, count, fingerprint);
+  arena->cuid_mapped_size = size;
+  return 1;
+}
+
+/*
+** Releases an arena, unmapping its slots if they were mapped by
+** `cuid_arena_map`.
+*/
+static inline void
+cuid_arena_destroy(cuid_arena_t *arena) {
+  if (arena->cuid_mapped_size != 0) {
+    munmap(arena->cuid_slots, arena->cuid_mapped_size);
+    arena->cuid_mapped_size = 0;
   }
+  arena->cuid_slots = 0x0;
+  arena->cuid_count = 0;
+}
 
-  return id;
+/*
+** Generates the next cuid of the generator at `index` into `result`.
+** Returns the length of the cuid string, or 0 if `index` is not a generator
+** of the arena.
+*/
+static inline size_t
+cuid_arena_next(cuid_arena_t *arena,
+                size_t const index,
+                unsigned long const timestamp,
+                char result[CUID_STATIC CUID_SIZE]) {
+  if (index >= arena->cuid_count) {
+    return 0;
+  }
+  cuid_arena_slot_t *slot = &arena->cuid_slots[index];
+#ifdef CUID_FORK_SAFE
+  // A child does not reuse the random numbers of its parent
+  if (slot->cuid_fork_epoch != CUID_FORK_EPOCH()) {
+    uint64_t seed = (uint64_t)MWC_SYSTEM_RAND32() << 32 | MWC_SYSTEM_RAND32();
+    cuid_arena_seed_slot(arena, index, &seed);
+    slot->cuid_fork_epoch = CUID_FORK_EPOCH();
+  }
+#endif /* CUID_FORK_SAFE */
+#ifdef CUID_ORDERED
+  // The counter starts again at 0 with each timestamp
+  unsigned long const last = slot->cuid_timestamp_value;
+  unsigned long const tick =
+    cuid_ordered_tick(last, slot->cuid_counter, timestamp);
+  slot->cuid_counter = tick != last ? 0 : slot->cuid_counter + 1;
+  slot->cuid_timestamp_value = tick;
+#else
+  unsigned long const tick = timestamp;
+  slot->cuid_counter += 1;
+#endif /* CUID_ORDERED */
+
+  result[0] = 'c';
+  if (tick != cuid_arena_timestamp_value) {
+    cuid_base36_timestamp(tick, cuid_arena_timestamp_block);
+    cuid_arena_timestamp_value = tick;
+  }
+  memcpy(&result[CUID_TIMESTAMP_OFFSET], cuid_arena_timestamp_block,
+         CUID_TIMESTAMP_LENGTH);
+  cuid_base36_block(slot->cuid_counter, &result[CUID_COUNTER_OFFSET]);
+  memcpy(&result[CUID_FINGERPRINT_OFFSET], arena->cuid_fingerprint,
+         CUID_BLOCK_LENGTH);
+  uint64_t const inc = arena->cuid_stream + 2 * (uint64_t)index;
+  uint64_t state = slot->cuid_rnd_state * CUID_PCG32_MULTIPLIER + inc;
+  cuid_base36_block(cuid_pcg32_output(state), &result[CUID_RANDOM1_OFFSET]);
+  state = state * CUID_PCG32_MULTIPLIER + inc;
+  cuid_base36_block(cuid_pcg32_output(state), &result[CUID_RANDOM2_OFFSET]);
+  slot->cuid_rnd_state = state;
+  result[CUID_SIZE - 1] = '\0';
+  return CUID_SIZE - 1;
 }
+#endif /* CUID_ARENA */
 
+/*-- MARK: Shared memory generator -------------------------------------------*/
 /*
-** Initializes a cuid_t data type.
-** Clears the cuid value and sets the timestamp to be the base36 string of the
-** provided argument.
-** Calls the initializes of each of the cuid_t attributes that need them to be
-** called.
+** A generator whose counter is shared by the processes of a host through a
+** `shm_open` segment, e.g. by prefork workers that share their fingerprint.
+**
+** The fingerprint of `cuid_get_fingerprint` only keeps 2 base36 chars of the
+** pid, so the workers of a host often get the same one. Here the counter
+** values are handed out by an atomic fetch-add on the segment, in blocks of
+** CUID_SHM_COUNTER_BLOCK values, so no two processes get the same counter
+** until CUID_COUNTER_MAX values were handed out, whatever their fingerprint.
+** A cuid only takes the next value of the block of its process, the segment
+** is only touched once per block.
 **
-** Returns an initialized cuid_t.
+** A `cuid_shm_t` is a handle on the segment that must only be used from one
+** thread at a time, each thread can open its own. A child process must not
+** keep using the handle of its parent, unless CUID_FORK_SAFE is defined, in
+** which case the child takes a new counter block and reseeds its random
+** numbers.
+**
+** Only available if CUID_SHM is defined, it needs CUID_THREADS, the POSIX
+** `shm_open` and a lock-free 64 bit atomic (so that it works across
+** processes).
 */
-static inline cuid_t
-cuid_init(cuid_t id, unsigned long const timestamp) {
-  // Initialize the counter
-  id.cuid_counter = CUID_INIT_COUNTER(id.cuid_counter);
-  // Initialize the PRNG's
-  id.cuid_rnd1 = CUID_INIT_RANDOM(id.cuid_rnd1);
-  id.cuid_rnd2 = CUID_INIT_RANDOM(id.cuid_rnd2);
-  // Set the timestamp
-  cuid_base36_pad(timestamp, id.cuid_timestamp, CUID_TIMESTAMP_LENGTH, '0');
-  // Clear the value
-  for (size_t i = 0; i < CUID_SIZE; ++i) {
-    id.cuid_value[i] = '\0';
+#ifdef CUID_SHM
+#ifndef CUID_THREADS
+#error "CUID_SHM needs CUID_THREADS for its atomic counter"
+#endif /* CUID_THREADS */
+#include <fcntl.h> // O_RDWR, O_CREAT
+#include <sys/mman.h> // mmap, munmap, shm_open, shm_unlink
+#include <sys/stat.h> // fstat
+#include <unistd.h> // close, ftruncate
+
+#ifndef CUID_SHM_COUNTER_BLOCK
+#define CUID_SHM_COUNTER_BLOCK (4096U)
+#endif /* CUID_SHM_COUNTER_BLOCK */
+
+typedef struct cuid_shm_segment_t {
+  // The first counter value of the next block, a new segment is zero filled
+  CUID_ATOMIC(uint64_t) cuid_counter;
+} cuid_shm_segment_t;
+
+typedef struct cuid_shm_t {
+  cuid_shm_segment_t *cuid_segment;
+  // The block of this handle, the counters from `cuid_counter` up to
+  // `cuid_counter_end` are left to use
+  uint64_t cuid_counter;
+  uint64_t cuid_counter_end;
+  cuid_pcg32_t cuid_rnd;
+#ifdef CUID_FORK_SAFE
+  // The fork epoch that the handle took its block in
+  uint32_t cuid_fork_epoch;
+#endif /* CUID_FORK_SAFE */
+  // The timestamp block last encoded by this handle
+  unsigned long cuid_timestamp_value;
+  char cuid_timestamp_block[CUID_TIMESTAMP_LENGTH];
+  char cuid_fingerprint[CUID_FINGERPRINT_SIZE];
+} cuid_shm_t;
+
+/*
+** Opens the shared memory segment `name` (a "/name" for `shm_open`),
+** creating it if needed, and initializes a handle on it whose cuids use the
+** provided fingerprint.
+** Returns 1 on success, 0 if the segment could not be opened or mapped.
+*/
+static inline int
+cuid_shm_open(cuid_shm_t *shm,
+              char const *name,
+              char const fingerprint[CUID_STATIC CUID_FINGERPRINT_SIZE]) {
+  int const fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+  if (fd < 0) {
+    return 0;
   }
-  // Generate a new value string and return the id
-  return cuid_gen_value_string(id);
+  struct stat status;
+  // Growing the segment zero fills it, an existing segment is kept as is
+  if (fstat(fd, &status) != 0
+      || ((size_t)status.st_size < sizeof(cuid_shm_segment_t)
+          && ftruncate(fd, (off_t)sizeof(cuid_shm_segment_t)) != 0)) {
+    close(fd);
+    return 0;
+  }
+  void *segment = mmap(0x0, sizeof(cuid_shm_segment_t),
+                       PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (segment == MAP_FAILED) {
+    return 0;
+  }
+  shm->cuid_segment = (cuid_shm_segment_t *)segment;
+  if (!atomic_is_lock_free(&shm->cuid_segment->cuid_counter)) {
+    munmap(segment, sizeof(cuid_shm_segment_t));
+    return 0;
+  }
+  CUID_FORK_EPOCH_WATCH();
+  shm->cuid_counter = 0;
+  shm->cuid_counter_end = 0;
+  cuid_pcg32_create_ptr(&shm->cuid_rnd);
+#ifdef CUID_FORK_SAFE
+  shm->cuid_fork_epoch = CUID_FORK_EPOCH();
+#endif /* CUID_FORK_SAFE */
+  shm->cuid_timestamp_value = ULONG_MAX;
+  memcpy(shm->cuid_fingerprint, fingerprint, CUID_FINGERPRINT_SIZE - 1);
+  shm->cuid_fingerprint[CUID_FINGERPRINT_SIZE - 1] = '\0';
+  return 1;
 }
 
 /*
-** Reads the cuid string value from the provided cuid_t.
-**
-** The value is copied into the `destination` char array passed as arg.
+** Unmaps the segment of a handle, the segment itself is kept for the other
+** processes until `cuid_shm_unlink`.
 */
 static inline void
-cuid_read(cuid_t const id, char destination[static CUID_SIZE]) {
-  for (size_t i = 0; i < CUID_SIZE; ++i) {
-    destination[i] = id.cuid_value[i];
-  }
+cuid_shm_close(cuid_shm_t *shm) {
+  munmap(shm->cuid_segment, sizeof(cuid_shm_segment_t));
+  shm->cuid_segment = 0x0;
 }
 
 /*
-** Advances the provided cuid_t into the next state.
-** This function creates the new random values and sets the timestamp string
-** into the cuid value string.
-**
-** It returns a new cuid_t with the new state to be used to read the cuid
-** string.
-**
-** A new cuid string can then be read from the returned id with `cuid_read`.
-** 
+** Removes the segment `name`, the processes that have it open keep using it.
+** Returns 1 on success, 0 otherwise.
 */
-static inline cuid_t
-cuid_next(cuid_t id, unsigned long const timestamp) {
-  // Increase the counter
-  id.cuid_counter = CUID_INCREASE_COUNTER(id.cuid_counter);
-  // and the PRNGs,
-  id.cuid_rnd1 = CUID_NEXT_RANDOM(id.cuid_rnd1);
-  id.cuid_rnd2 = CUID_NEXT_RANDOM(id.cuid_rnd2);
-  // and set the timestamp
-  cuid_base36_pad(timestamp, id.cuid_timestamp, CUID_TIMESTAMP_LENGTH, '0');
+static inline int
+cuid_shm_unlink(char const *name) {
+  return shm_unlink(name) == 0;
+}
+
+/*
+** Generates the next cuid of a handle into `result`.
+** Returns the length of the cuid string.
+*/
+static inline size_t
+cuid_shm_next(cuid_shm_t *shm,
+              unsigned long const timestamp,
+              char result[CUID_STATIC CUID_SIZE]) {
+#ifdef CUID_FORK_SAFE
+  // A child does not reuse the counter block or the random numbers of its
+  // parent
+  if (shm->cuid_fork_epoch != CUID_FORK_EPOCH()) {
+    shm->cuid_counter = shm->cuid_counter_end;
+    cuid_pcg32_create_ptr(&shm->cuid_rnd);
+    shm->cuid_fork_epoch = CUID_FORK_EPOCH();
+  }
+#endif /* CUID_FORK_SAFE */
+  if (shm->cuid_counter == shm->cuid_counter_end) {
+    shm->cuid_counter = atomic_fetch_add_explicit(
+      &shm->cuid_segment->cuid_counter, CUID_SHM_COUNTER_BLOCK,
+      memory_order_relaxed);
+    shm->cuid_counter_end = shm->cuid_counter + CUID_SHM_COUNTER_BLOCK;
+  }
+  uint64_t const counter = shm->cuid_counter++;
 
-  // Generate a new value string into the id, and return it
-  return cuid_gen_value_string(id);
+  result[0] = 'c';
+  if (timestamp != shm->cuid_timestamp_value) {
+    cuid_base36_timestamp(timestamp, shm->cuid_timestamp_block);
+    shm->cuid_timestamp_value = timestamp;
+  }
+  memcpy(&result[CUID_TIMESTAMP_OFFSET], shm->cuid_timestamp_block,
+         CUID_TIMESTAMP_LENGTH);
+  cuid_base36_block((uint32_t)(counter % CUID_COUNTER_MAX),
+                    &result[CUID_COUNTER_OFFSET]);
+  memcpy(&result[CUID_FINGERPRINT_OFFSET], shm->cuid_fingerprint,
+         CUID_BLOCK_LENGTH);
+  cuid_pcg32_next_ptr(&shm->cuid_rnd);
+  cuid_base36_block(cuid_pcg32_read_ptr(&shm->cuid_rnd),
+                    &result[CUID_RANDOM1_OFFSET]);
+  cuid_pcg32_next_ptr(&shm->cuid_rnd);
+  cuid_base36_block(cuid_pcg32_read_ptr(&shm->cuid_rnd),
+                    &result[CUID_RANDOM2_OFFSET]);
+  result[CUID_SIZE - 1] = '\0';
+  return CUID_SIZE - 1;
 }
+#endif /* CUID_SHM */
 
 #endif // CUID_PURE
 
@@ -630,27 +4441,377 @@ cuid_next(cuid_t id, unsigned long const timestamp) {
 ** Implements CUID as the string made of
 ** letter + timestamp + counter + fingerprint + random;
 */
-size_t cuid(char result[static CUID_SIZE]) {
-  static uint32_t counter = 0;
+// The counters of `cuid()` and `cuid_n()`, see `cuid_thread_stats`
+static CUID_THREAD_LOCAL cuid_stats_t cuid_local_stats = {0, 0, 0, 0, 0};
+
+void cuid_thread_stats(cuid_stats_t *stats) {
+  *stats = cuid_local_stats;
+}
+
+#ifdef CUID_THREADS
+// The start of the next free counter range
+static CUID_ATOMIC(uint32_t) cuid_counter_ranges = 0;
+// The counter of the current thread and the end of its reserved range
+static CUID_THREAD_LOCAL uint32_t cuid_counter = 0;
+static CUID_THREAD_LOCAL uint32_t cuid_counter_end = 0;
+
+#if CUID_WRAP_POLICY != CUID_WRAP_IGNORE
+// The low 32 bits of the latest timestamp in the high half and the first
+// counter reserved with it in the low half
+static CUID_ATOMIC(uint64_t) cuid_counter_tick = UINT64_MAX;
+// If the current range was checked for a counter wrap
+static CUID_THREAD_LOCAL int cuid_counter_checked = 0;
+
+/*
+** Checks that the counters from `start` to `end` do not wrap around within
+** `timestamp`, starting a new tick if it is the first range used with it.
+** Returns 1 if they do not, 0 otherwise.
+*/
+static inline int
+cuid_counter_tick_check(unsigned long const timestamp,
+                        uint32_t const start,
+                        uint32_t const end) {
+  uint32_t const ts = (uint32_t)timestamp;
+  uint64_t tick = atomic_load_explicit(&cuid_counter_tick,
+                                       memory_order_relaxed);
+  for (;;) {
+    uint32_t const tick_ts = (uint32_t)(tick >> 32);
+    if (tick != UINT64_MAX && tick_ts == ts) {
+      return end - (uint32_t)tick <= CUID_COUNTER_MAX;
+    }
+    // An older timestamp, from a thread that read the clock before a tick.
+    // Only the low 32 bits are kept, which wrap around every 49.7 days of
+    // milliseconds, so the timestamps are compared across the wrap
+    if (tick != UINT64_MAX && (uint32_t)(ts - tick_ts) > UINT32_MAX / 2) {
+      return 1;
+    }
+    if (atomic_compare_exchange_weak_explicit(&cuid_counter_tick, &tick,
+          ((uint64_t)ts << 32) | start,
+          memory_order_relaxed, memory_order_relaxed)) {
+      return 1;
+    }
+  }
+}
+#endif /* CUID_WRAP_POLICY */
+
+/*
+** Places the next counter value in `counter`, reserving a new range of
+** counters for this thread when the current one is used up.
+** Returns 0 if the counter would wrap around within `timestamp`, see
+** CUID_WRAP_POLICY, 1 otherwise.
+*/
+static inline int
+cuid_next_counter(unsigned long const timestamp, uint32_t *counter) {
+  if (cuid_counter == cuid_counter_end) {
+    cuid_counter = atomic_fetch_add_explicit(&cuid_counter_ranges,
+                                             CUID_COUNTER_RANGE,
+                                             memory_order_relaxed);
+    cuid_counter_end = cuid_counter + CUID_COUNTER_RANGE;
+#if CUID_WRAP_POLICY != CUID_WRAP_IGNORE
+    cuid_counter_checked = 0;
+#endif /* CUID_WRAP_POLICY */
+  }
+#if CUID_WRAP_POLICY != CUID_WRAP_IGNORE
+  if (!cuid_counter_checked) {
+    if (!cuid_counter_tick_check(timestamp, cuid_counter, cuid_counter_end)) {
+      return 0;
+    }
+    cuid_counter_checked = 1;
+  }
+#else
+  (void)timestamp;
+#endif /* CUID_WRAP_POLICY */
+  *counter = ++cuid_counter;
+  return 1;
+}
+#else
+static uint32_t cuid_counter = 0;
+#if CUID_WRAP_POLICY != CUID_WRAP_IGNORE
+// The latest timestamp and the counter value when it started
+static unsigned long cuid_tick_timestamp = ULONG_MAX;
+static uint32_t cuid_tick_counter = 0;
+#endif /* CUID_WRAP_POLICY */
+
+static inline int
+cuid_next_counter(unsigned long const timestamp, uint32_t *counter) {
+#if CUID_WRAP_POLICY != CUID_WRAP_IGNORE
+  if (timestamp != cuid_tick_timestamp) {
+    cuid_tick_timestamp = timestamp;
+    cuid_tick_counter = cuid_counter;
+  } else if (cuid_counter - cuid_tick_counter >= CUID_COUNTER_MAX) {
+    return 0;
+  }
+#else
+  (void)timestamp;
+#endif /* CUID_WRAP_POLICY */
+  *counter = ++cuid_counter;
+  return 1;
+}
+#endif /* CUID_THREADS */
+
+/*
+** Places the next counter value in `counter`, applying CUID_WRAP_POLICY if
+** it would wrap around within `*timestamp`. With CUID_WRAP_SPIN the newer
+** timestamp waited for is placed in `timestamp`.
+** Returns 0 if no counter can be used (with CUID_WRAP_FAIL), 1 otherwise.
+*/
+static inline int
+cuid_wrap_counter(unsigned long *timestamp, uint32_t *counter) {
+  while (!cuid_next_counter(*timestamp, counter)) {
+    CUID_STATS_ADD(&cuid_local_stats, cuid_counter_wraps, 1);
+#if CUID_WRAP_POLICY == CUID_WRAP_SPIN
+    unsigned long const wrapped = *timestamp;
+    while ((*timestamp = CUID_GET_TIMESTAMP()) == wrapped) {
+      // Spin until the next tick
+    }
+#else
+    return 0;
+#endif /* CUID_WRAP_POLICY */
+  }
+  CUID_STATS_ADD(&cuid_local_stats, cuid_counter_wraps,
+                 *counter % CUID_COUNTER_MAX == 0);
+  return 1;
+}
+
+/*
+** CUID_ATFORK is defined when a `pthread_atfork()` handler clears the caches
+** of `cuid()` in a child process: with CUID_FORK_SAFE, and with
+** CUID_BUFFERED_RANDOM where the POSIX threads are available, so a child
+** never takes the random numbers left in the buffer of its parent.
+*/
+#include <unistd.h> // _POSIX_THREADS
+#if defined(CUID_FORK_SAFE) || (defined(CUID_BUFFERED_RANDOM) \
+  && defined(_POSIX_THREADS) && _POSIX_THREADS > 0)
+#include <pthread.h> // pthread_atfork, pthread_once
+#define CUID_ATFORK (1)
+#endif /* CUID_ATFORK */
+
+// The encoded timestamp block
+static CUID_THREAD_LOCAL cuid_timestamp_cache_t cuid_timestamp_cache =
+  CUID_TIMESTAMP_CACHE_INIT;
+
+// The fingerprint cache, a length of 0 means that it is not set
+static CUID_THREAD_LOCAL char cuid_fingerprint_cache[CUID_FINGERPRINT_SIZE];
+static CUID_THREAD_LOCAL size_t cuid_fingerprint_length = 0;
+
+void cuid_fingerprint_reset(void) {
+  cuid_fingerprint_length = 0;
+}
+
+#ifdef CUID_BUFFERED_RANDOM
+#ifndef CUID_RANDOM_BUFFER_SIZE
+#define CUID_RANDOM_BUFFER_SIZE (4096)
+#endif /* CUID_RANDOM_BUFFER_SIZE */
+#ifndef CUID_SYSTEM_RANDOM_BUF
+#define CUID_SYSTEM_RANDOM_BUF arc4random_buf
+#endif /* CUID_SYSTEM_RANDOM_BUF */
+#define CUID_RANDOM_BUFFER_LENGTH (CUID_RANDOM_BUFFER_SIZE / sizeof(uint32_t))
+
+// The random numbers buffer and the position of the next number to use
+static CUID_THREAD_LOCAL uint32_t
+  cuid_random_buffer[CUID_RANDOM_BUFFER_LENGTH];
+static CUID_THREAD_LOCAL size_t
+  cuid_random_position = CUID_RANDOM_BUFFER_LENGTH;
+
+#ifdef CUID_ATFORK
+static void cuid_register_atfork_once(void);
+#endif /* CUID_ATFORK */
+
+/*
+** Returns the next random number from the buffer, refilling it with
+** CUID_SYSTEM_RANDOM_BUF when all of its numbers were used.
+*/
+static inline uint32_t
+cuid_buffered_rand32(void) {
+  if (cuid_random_position == CUID_RANDOM_BUFFER_LENGTH) {
+#ifdef CUID_ATFORK
+    cuid_register_atfork_once();
+#endif /* CUID_ATFORK */
+    CUID_SYSTEM_RANDOM_BUF(cuid_random_buffer, sizeof cuid_random_buffer);
+    cuid_random_position = 0;
+    CUID_STATS_ADD(&cuid_local_stats, cuid_random_refills, 1);
+  }
+  return cuid_random_buffer[cuid_random_position++];
+}
+
+// The random function used by `cuid()` and `cuid_n()`
+#define CUID_RAND32 cuid_buffered_rand32
+#else
+#define CUID_RAND32 MWC_SYSTEM_RAND32
+#endif /* CUID_BUFFERED_RANDOM */
+
+// Without CUID_BUFFERED_RANDOM there are no numbers to discard
+void cuid_random_reset(void) {
+#ifdef CUID_BUFFERED_RANDOM
+  cuid_random_position = CUID_RANDOM_BUFFER_LENGTH;
+#endif /* CUID_BUFFERED_RANDOM */
+  CUID_STATS_ADD(&cuid_local_stats, cuid_reseeds, 1);
+}
+
+#ifdef CUID_ATFORK
+static void
+cuid_atfork_child(void) {
+#ifdef CUID_FORK_SAFE
+  cuid_fingerprint_reset();
+#endif /* CUID_FORK_SAFE */
+  cuid_random_reset();
+}
+
+static void
+cuid_register_atfork(void) {
+  pthread_atfork(0x0, 0x0, cuid_atfork_child);
+}
+
+// Registers the handler the first time that a cache of `cuid()` is filled
+static void
+cuid_register_atfork_once(void) {
+  static pthread_once_t cuid_atfork_once = PTHREAD_ONCE_INIT;
+  pthread_once(&cuid_atfork_once, cuid_register_atfork);
+}
+#endif /* CUID_ATFORK */
+
+/*
+** Copies the cached fingerprint into `result`, calling CUID_GET_FINGERPRINT
+** if it is not cached yet.
+** Returns the length of the fingerprint.
+*/
+static inline size_t
+cuid_cached_fingerprint(char result[CUID_STATIC CUID_FINGERPRINT_SIZE]) {
+  if (cuid_fingerprint_length == 0) {
+#ifdef CUID_FORK_SAFE
+    cuid_register_atfork_once();
+#endif /* CUID_FORK_SAFE */
+    cuid_fingerprint_length = CUID_GET_FINGERPRINT(cuid_fingerprint_cache);
+  }
+  for (size_t i = 0; i < cuid_fingerprint_length; ++i) {
+    result[i] = cuid_fingerprint_cache[i];
+  }
+  return cuid_fingerprint_length;
+}
+
+size_t cuid(char result[CUID_STATIC CUID_SIZE]) {
+  CUID_TRACE_BEGIN("cuid");
   size_t length = 1;
+  CUID_TRACE_BEGIN("timestamp");
+  unsigned long timestamp = CUID_GET_TIMESTAMP();
+  CUID_TRACE_END("timestamp");
+  uint32_t counter = 0;
+  if (!cuid_wrap_counter(&timestamp, &counter)) {
+    result[0] = '\0';
+    CUID_TRACE_END("cuid");
+    return 0;
+  }
   // Letter
   result[0] = 'c';
-  // Timestamp (padded and limited at 6 chars)
-  length += cuid_base36_pad(CUID_GET_TIMESTAMP(), &result[1], 6, '0');
+  // Timestamp (its lowest CUID_TIMESTAMP_LENGTH base36 digits, zero padded),
+  // from the cache that only encodes it again when the timestamp changes
+  int const changed =
+    cuid_timestamp_cache_update(&cuid_timestamp_cache, timestamp);
+  CUID_STATS_ADD(&cuid_local_stats, cuid_timestamp_changes, (uint64_t)changed);
+  for (size_t i = 0; i < CUID_TIMESTAMP_LENGTH; ++i) {
+    result[length + i] = cuid_timestamp_cache.block[i];
+  }
+  length += CUID_TIMESTAMP_LENGTH;
   // Counter (4 chars)
-  length += cuid_base36_pad(++counter, &result[length], 4, '0');
+  cuid_base36_block(counter, &result[length]);
+  length += 4;
   // Fingerprint (4 chars, 2 PID + 2 Hostname)
-  length += CUID_GET_FINGERPRINT(&result[length]);
-  // Random block 1 (4 chars)
-  length += cuid_base36_pad(MWC_SYSTEM_RAND32(), &result[length], 4, '0');
-  // Random block 2 (4 chars)
-  length += cuid_base36_pad(MWC_SYSTEM_RAND32(), &result[length], 4, '0');
+  CUID_TRACE_BEGIN("fingerprint");
+  length += cuid_cached_fingerprint(&result[length]);
+  CUID_TRACE_END("fingerprint");
+  // Random blocks 1 and 2 (4 chars each)
+  CUID_TRACE_BEGIN("random");
+  uint32_t const random1 = CUID_RAND32();
+  uint32_t const random2 = CUID_RAND32();
+  CUID_TRACE_END("random");
+  cuid_base36_block(random1, &result[length]);
+  length += 4;
+  cuid_base36_block(random2, &result[length]);
+  length += 4;
 
   result[CUID_SIZE - 1] = '\0';
+  CUID_STATS_ADD(&cuid_local_stats, cuid_generated, 1);
+  CUID_TRACE_END("cuid");
 
   return length;
 }
 
+/*
+** Implements the batch version of `cuid()`, the letter, timestamp and
+** fingerprint are the same for the whole batch and are formatted once.
+*/
+size_t cuid_n(char result[][CUID_SIZE], size_t n) {
+  if (n == 0) {
+    return 0;
+  }
+  CUID_TRACE_BEGIN("cuid_n");
+  // Letter, timestamp and fingerprint, formatted once
+  char prefix[CUID_COUNTER_OFFSET] = {0};
+  char fingerprint[CUID_FINGERPRINT_SIZE] = {0};
+  CUID_TRACE_BEGIN("timestamp");
+  unsigned long timestamp = CUID_GET_TIMESTAMP();
+  CUID_TRACE_END("timestamp");
+  prefix[0] = 'c';
+  int const changed =
+    cuid_timestamp_cache_update(&cuid_timestamp_cache, timestamp);
+  CUID_STATS_ADD(&cuid_local_stats, cuid_timestamp_changes, (uint64_t)changed);
+  for (size_t i = 0; i < CUID_TIMESTAMP_LENGTH; ++i) {
+    prefix[1 + i] = cuid_timestamp_cache.block[i];
+  }
+  CUID_TRACE_BEGIN("fingerprint");
+  cuid_cached_fingerprint(fingerprint);
+  CUID_TRACE_END("fingerprint");
+
+  // The numbers of each chunk, formatted together by `cuid_base36_blocks`
+  uint32_t numbers[3][CUID_BATCH_CHUNK];
+  for (size_t start = 0; start < n; start += CUID_BATCH_CHUNK) {
+    size_t chunk_size = n - start < CUID_BATCH_CHUNK ?
+                        n - start : CUID_BATCH_CHUNK;
+    for (size_t n_i = 0; n_i < chunk_size; ++n_i) {
+      unsigned long const previous = timestamp;
+      if (!cuid_wrap_counter(&timestamp, &numbers[0][n_i])) {
+        chunk_size = n_i;
+        n = start + n_i;
+        break;
+      }
+      if (timestamp != previous) {
+        // A new tick was waited for, the rest of the cuids use it
+        int const ticked =
+          cuid_timestamp_cache_update(&cuid_timestamp_cache, timestamp);
+        CUID_STATS_ADD(&cuid_local_stats, cuid_timestamp_changes,
+                       (uint64_t)ticked);
+        for (size_t i = 0; i < CUID_TIMESTAMP_LENGTH; ++i) {
+          prefix[1 + i] = cuid_timestamp_cache.block[i];
+        }
+      }
+      char *chunk_result = result[start + n_i];
+      for (size_t i = 0; i < CUID_COUNTER_OFFSET; ++i) {
+        chunk_result[i] = prefix[i];
+      }
+      for (size_t i = 0; i < CUID_BLOCK_LENGTH; ++i) {
+        chunk_result[CUID_FINGERPRINT_OFFSET + i] = fingerprint[i];
+      }
+      chunk_result[CUID_SIZE - 1] = '\0';
+    }
+    CUID_TRACE_BEGIN("random");
+    for (size_t n_i = 0; n_i < chunk_size; ++n_i) {
+      numbers[1][n_i] = CUID_RAND32();
+      numbers[2][n_i] = CUID_RAND32();
+    }
+    CUID_TRACE_END("random");
+    cuid_base36_blocks(numbers[0], chunk_size,
+                       &result[start][CUID_COUNTER_OFFSET], CUID_SIZE);
+    cuid_base36_blocks(numbers[1], chunk_size,
+                       &result[start][CUID_RANDOM1_OFFSET], CUID_SIZE);
+    cuid_base36_blocks(numbers[2], chunk_size,
+                       &result[start][CUID_RANDOM2_OFFSET], CUID_SIZE);
+  }
+  CUID_STATS_ADD(&cuid_local_stats, cuid_generated, n);
+  CUID_TRACE_END("cuid_n");
+
+  return n;
+}
+
 #endif // CUID_IMPL
 
 /*-- MARK: Tests -------------------------------------------------------------*/
@@ -662,3 +4823,12 @@ size_t cuid(char result[static CUID_SIZE]) {
 #include "./tests/cuid_tests.h"
 #endif /* CUID_TESTS */
 
+/*-- MARK: Benchmarks --------------------------------------------------------*/
+/*
+** Include the benchmarks if cuid is being built for benchmarking
+**/
+#ifdef CUID_BENCH
+
+#include "./bench/cuid_bench.h"
+#endif /* CUID_BENCH */
+
@@ -0,0 +1,457 @@
+#ifndef CUID_HPP
+/*
+** The C++ wrapper of cuid.h.
+**
+** Include this file instead of cuid.h in C++ code, it enables the pure API
+** of cuid.h and adds the `cuidpp` namespace (`cuid` is already the name of
+** the `cuid()` function) with a generator of cuids whose layout is chosen at
+** compile time:
+**
+**   cuidpp::generator<> gen; // The default layout of cuid.h
+**   cuidpp::id id = gen.next(timestamp);
+**
+**   // An 8 chars timestamp and 6 chars counter, fingerprint and randoms
+**   cuidpp::generator<cuidpp::layout<8, 6>> long_gen;
+**
+** The length of each block is a template parameter, so every block is
+** formatted by an encoder of a fixed width that the compiler fully unrolls,
+** there are no loops or bounds checks left at runtime.
+**
+** `cuidpp::pure_generator` makes the same cuids as the pure API of cuid.h,
+** it owns its `cuid_t` state through a pointer.
+**
+** The generators are move-only, a copy would repeat the cuids of the
+** original. Their `next()` and `generate_n()` never allocate memory.
+**
+** Needs C++17, the cuids have `operator<=>` with C++20.
+*/
+#define CUID_HPP (1)
+#ifndef CUID_PURE
+#define CUID_PURE (1)
+#endif /* CUID_PURE */
+#include "cuid.h"
+#include <array> // std::array
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint32_t, std::uint64_t
+#include <cstring> // std::memcmp
+#include <functional> // std::hash
+#include <memory> // std::unique_ptr
+#include <string_view> // std::string_view
+#if defined(__cpp_impl_three_way_comparison) \
+  && __cpp_impl_three_way_comparison >= 201907L
+#include <compare> // std::strong_ordering
+#define CUIDPP_THREE_WAY_COMPARISON (1)
+#endif
+
+namespace cuidpp {
+
+// The base36 digits, as in `cuid_base36_digits`
+inline constexpr char digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+/*
+** The table of all of the 36 * 36 pairs of base36 digits, as in
+** `cuid_base36_pairs`, built at compile time.
+*/
+struct base36_pairs {
+  char chars[36 * 36 * 2];
+
+  constexpr base36_pairs() : chars() {
+    for (std::size_t i = 0; i < 36 * 36; ++i) {
+      chars[2 * i] = digits[i / 36];
+      chars[2 * i + 1] = digits[i % 36];
+    }
+  }
+};
+
+inline constexpr base36_pairs pairs{};
+
+// Returns 36 ^ `exponent`
+constexpr std::uint64_t
+base36_power(std::size_t exponent) noexcept {
+  std::uint64_t power = 1;
+  for (std::size_t i = 0; i < exponent; ++i) {
+    power *= 36;
+  }
+  return power;
+}
+
+/*
+** Writes the lowest `Width` base36 digits of `number` into `result`, zero
+** padded on the left, like `cuid_base36_fixed`. No '\0' is written at the
+** end. Each pair of digits is its own step, the recursion is resolved at
+** compile time.
+*/
+template <std::size_t Width>
+constexpr void
+encode_base36(std::uint64_t number, char *result) noexcept {
+  if constexpr (Width >= 2) {
+    std::uint64_t const quotient = number / 1296;
+    std::size_t const pair = 2 * static_cast<std::size_t>(number % 1296);
+    result[Width - 2] = pairs.chars[pair];
+    result[Width - 1] = pairs.chars[pair + 1];
+    encode_base36<Width - 2>(quotient, result);
+  } else if constexpr (Width == 1) {
+    result[0] = digits[number % 36];
+  }
+}
+
+/*
+** The layout of a cuid: the letter 'c', a timestamp block of
+** `TimestampLength` chars and the counter, fingerprint and two random blocks
+** of `BlockLength` chars each, then a '\0'.
+**
+** The blocks are made from 64 bit numbers, so both lengths go up to 12
+** (36^12 < 2^64).
+*/
+template <std::size_t TimestampLength = CUID_TIMESTAMP_LENGTH,
+          std::size_t BlockLength = CUID_BLOCK_LENGTH>
+struct layout {
+  static_assert(TimestampLength >= 1 && TimestampLength <= 12,
+                "The timestamp length must be from 1 to 12");
+  static_assert(BlockLength >= 1 && BlockLength <= 12,
+                "The block length must be from 1 to 12");
+
+  static constexpr std::size_t timestamp_length = TimestampLength;
+  static constexpr std::size_t block_length = BlockLength;
+  // The position of each block
+  static constexpr std::size_t timestamp_offset = 1;
+  static constexpr std::size_t counter_offset =
+    timestamp_offset + timestamp_length;
+  static constexpr std::size_t fingerprint_offset =
+    counter_offset + block_length;
+  static constexpr std::size_t random1_offset =
+    fingerprint_offset + block_length;
+  static constexpr std::size_t random2_offset = random1_offset + block_length;
+  // The size of a cuid string, with its '\0'
+  static constexpr std::size_t size = random2_offset + block_length + 1;
+  // The number of values of a block, the counter wraps around after these
+  static constexpr std::uint64_t block_max = base36_power(block_length);
+};
+
+/*
+** A cuid string of `Size` chars, with its '\0', held by value.
+**
+** Compares in the order of `strcmp` and hashes with `cuid_hash`, so it can be
+** used as the key of the ordered and unordered containers.
+*/
+template <std::size_t Size>
+struct basic_id {
+  std::array<char, Size> chars;
+
+  // The length of the cuid string, without the '\0'
+  static constexpr std::size_t
+  size() noexcept {
+    return Size - 1;
+  }
+
+  char const *
+  data() const noexcept {
+    return chars.data();
+  }
+
+  char const *
+  c_str() const noexcept {
+    return chars.data();
+  }
+
+  std::string_view
+  view() const noexcept {
+    return std::string_view(chars.data(), Size - 1);
+  }
+
+  operator std::string_view() const noexcept {
+    return view();
+  }
+
+  // The hash of the cuid, `cuid_hash` for the cuids of cuid.h
+  std::uint64_t
+  hash() const noexcept {
+    if constexpr (Size >= 8) {
+      return cuid_hash_bytes(bytes(), Size);
+    } else {
+      return std::hash<std::string_view>{}(view());
+    }
+  }
+
+  // Compares as `memcmp`, with the word compares of `cuid_compare`
+  static int
+  compare(basic_id const &a, basic_id const &b) noexcept {
+    if constexpr (Size >= 8) {
+      return cuid_compare_bytes(a.bytes(), b.bytes(), Size);
+    } else {
+      return std::memcmp(a.chars.data(), b.chars.data(), Size);
+    }
+  }
+
+  friend bool
+  operator==(basic_id const &a, basic_id const &b) noexcept {
+    if constexpr (Size >= 8) {
+      return cuid_equal_bytes(a.bytes(), b.bytes(), Size);
+    } else {
+      return std::memcmp(a.chars.data(), b.chars.data(), Size) == 0;
+    }
+  }
+#ifdef CUIDPP_THREE_WAY_COMPARISON
+  friend std::strong_ordering
+  operator<=>(basic_id const &a, basic_id const &b) noexcept {
+    return compare(a, b) <=> 0;
+  }
+#else
+  friend bool
+  operator!=(basic_id const &a, basic_id const &b) noexcept {
+    return !(a == b);
+  }
+  friend bool
+  operator<(basic_id const &a, basic_id const &b) noexcept {
+    return compare(a, b) < 0;
+  }
+  friend bool
+  operator>(basic_id const &a, basic_id const &b) noexcept {
+    return b < a;
+  }
+  friend bool
+  operator<=(basic_id const &a, basic_id const &b) noexcept {
+    return !(b < a);
+  }
+  friend bool
+  operator>=(basic_id const &a, basic_id const &b) noexcept {
+    return !(a < b);
+  }
+#endif /* CUIDPP_THREE_WAY_COMPARISON */
+
+private:
+  unsigned char const *
+  bytes() const noexcept {
+    return reinterpret_cast<unsigned char const *>(chars.data());
+  }
+};
+
+// The cuids of the default layout, as made by cuid.h
+using id = basic_id<CUID_SIZE>;
+
+/*
+** A cuid generator for a `Layout`.
+**
+** It keeps a counter, the fingerprint block and a PCG32 generator
+** (`cuid_pcg32_t`), the random blocks longer than 6 chars are made from two
+** of its numbers.
+*/
+template <class Layout = layout<>>
+class generator {
+public:
+  using layout_type = Layout;
+  static constexpr std::size_t size = Layout::size;
+  using id_type = basic_id<size>;
+
+  // Uses the fingerprint of CUID_GET_FINGERPRINT
+  generator() : generator(default_fingerprint().data()) {}
+
+  generator(generator const &) = delete;
+  generator &operator=(generator const &) = delete;
+  generator(generator &&) noexcept = default;
+  generator &operator=(generator &&) noexcept = default;
+
+  /*
+  ** Uses the 4 chars `fingerprint` (as given to `cuid_create`), zero padded
+  ** on the left for longer blocks or cut to its last chars for shorter ones.
+  */
+  explicit generator(char const *fingerprint) : counter_(0), random_() {
+    cuid_pcg32_create_ptr(&random_);
+    std::size_t const length = CUID_FINGERPRINT_SIZE - 1;
+    for (std::size_t i = 0; i < Layout::block_length; ++i) {
+      std::size_t const pad = Layout::block_length - i;
+      fingerprint_[i] = pad > length ? '0' : fingerprint[length - pad];
+    }
+  }
+
+  /*
+  ** Writes the next cuid of the generator into `result`.
+  ** Returns the length of the cuid string.
+  */
+  std::size_t
+  next(unsigned long const timestamp, char (&result)[size]) noexcept {
+    return write(timestamp, result);
+  }
+
+  // Returns the next cuid of the generator
+  id_type
+  next(unsigned long const timestamp = CUID_GET_TIMESTAMP()) noexcept {
+    id_type result;
+    write(timestamp, result.chars.data());
+    return result;
+  }
+
+  /*
+  ** Writes the next `n` cuids (as `id_type`) through the `out` output
+  ** iterator, all of them with the same timestamp.
+  ** Returns the iterator past the last cuid written.
+  */
+  template <class OutputIt>
+  OutputIt
+  generate_n(OutputIt out, std::size_t const n,
+             unsigned long const timestamp = CUID_GET_TIMESTAMP()) {
+    for (std::size_t i = 0; i < n; ++i, ++out) {
+      *out = next(timestamp);
+    }
+    return out;
+  }
+
+private:
+  static std::array<char, CUID_FINGERPRINT_SIZE>
+  default_fingerprint() {
+    std::array<char, CUID_FINGERPRINT_SIZE> fingerprint{};
+    CUID_GET_FINGERPRINT(fingerprint.data());
+    return fingerprint;
+  }
+
+  std::size_t
+  write(unsigned long const timestamp, char *result) noexcept {
+    result[0] = 'c';
+    encode_base36<Layout::timestamp_length>(
+      timestamp, &result[Layout::timestamp_offset]);
+    encode_base36<Layout::block_length>(
+      counter_, &result[Layout::counter_offset]);
+    counter_ = (counter_ + 1) % Layout::block_max;
+    for (std::size_t i = 0; i < Layout::block_length; ++i) {
+      result[Layout::fingerprint_offset + i] = fingerprint_[i];
+    }
+    encode_base36<Layout::block_length>(
+      next_random(), &result[Layout::random1_offset]);
+    encode_base36<Layout::block_length>(
+      next_random(), &result[Layout::random2_offset]);
+    result[size - 1] = '\0';
+    return size - 1;
+  }
+
+  // Returns a random number of at least `Layout::block_length` digits
+  std::uint64_t
+  next_random() noexcept {
+    cuid_pcg32_next_ptr(&random_);
+    std::uint64_t number = cuid_pcg32_read_ptr(&random_);
+    if constexpr (Layout::block_length > 6) {
+      // 36^6 < 2^32, longer blocks need a second number
+      cuid_pcg32_next_ptr(&random_);
+      number = number << 32 | cuid_pcg32_read_ptr(&random_);
+    }
+    return number;
+  }
+
+  std::uint64_t counter_;
+  cuid_pcg32_t random_;
+  char fingerprint_[Layout::block_length];
+};
+
+/*
+** A cuid generator with the `cuid_t` state of the pure API, it makes the
+** same cuids as `cuid_next_inplace` + `cuid_read_ptr`, and follows the
+** CUID_* macros of the random and counter generators.
+**
+** The state is allocated once, at construction, and owned through a pointer
+** so moving a generator does not copy it. A moved-from generator can only be
+** assigned to or destroyed.
+*/
+class pure_generator {
+public:
+  static constexpr std::size_t size = CUID_SIZE;
+  using id_type = basic_id<size>;
+
+  // Uses the fingerprint of CUID_GET_FINGERPRINT
+  pure_generator() : pure_generator(default_fingerprint().data()) {}
+
+  // Uses the 4 chars `fingerprint`, as given to `cuid_create_inplace`
+  explicit pure_generator(char const *fingerprint,
+                          unsigned long const timestamp = CUID_GET_TIMESTAMP())
+    : state_(new cuid_t) {
+    cuid_create_inplace(state_.get(), fingerprint);
+    cuid_init_inplace(state_.get(), timestamp);
+  }
+
+  pure_generator(pure_generator const &) = delete;
+  pure_generator &operator=(pure_generator const &) = delete;
+  pure_generator(pure_generator &&) noexcept = default;
+  pure_generator &operator=(pure_generator &&) noexcept = default;
+
+  /*
+  ** Writes the next cuid of the generator into `result`.
+  ** Returns the length of the cuid string.
+  */
+  std::size_t
+  next(unsigned long const timestamp, char (&result)[size]) noexcept {
+    return write(timestamp, result);
+  }
+
+  // Returns the next cuid of the generator
+  id_type
+  next(unsigned long const timestamp = CUID_GET_TIMESTAMP()) noexcept {
+    id_type result;
+    write(timestamp, result.chars.data());
+    return result;
+  }
+
+  /*
+  ** Writes the next `n` cuids (as `id_type`) through the `out` output
+  ** iterator, all of them with the same timestamp.
+  ** Returns the iterator past the last cuid written.
+  */
+  template <class OutputIt>
+  OutputIt
+  generate_n(OutputIt out, std::size_t const n,
+             unsigned long const timestamp = CUID_GET_TIMESTAMP()) {
+    for (std::size_t i = 0; i < n; ++i, ++out) {
+      *out = next(timestamp);
+    }
+    return out;
+  }
+
+  // Reseeds the state, see `cuid_reseed_inplace`
+  void
+  reseed(std::uint64_t const entropy = cuid_fresh_entropy()) noexcept {
+    cuid_reseed_inplace(state_.get(), entropy);
+  }
+
+  // The `cuid_t` state, to use it with the functions of cuid.h
+  cuid_t *
+  state() noexcept {
+    return state_.get();
+  }
+
+private:
+  static std::array<char, CUID_FINGERPRINT_SIZE>
+  default_fingerprint() {
+    std::array<char, CUID_FINGERPRINT_SIZE> fingerprint{};
+    CUID_GET_FINGERPRINT(fingerprint.data());
+    return fingerprint;
+  }
+
+  std::size_t
+  write(unsigned long const timestamp, char *result) noexcept {
+    cuid_advance_inplace(state_.get(), timestamp);
+    return cuid_format(state_.get(), result);
+  }
+
+  std::unique_ptr<cuid_t> state_;
+};
+
+} // namespace cuidpp
+
+namespace std {
+// Hashes a cuid with `cuid_hash`
+template <std::size_t Size>
+struct hash<cuidpp::basic_id<Size>> {
+  std::size_t
+  operator()(cuidpp::basic_id<Size> const &id) const noexcept {
+    return static_cast<std::size_t>(id.hash());
+  }
+};
+} // namespace std
+
+/*-- MARK: Tests -------------------------------------------------------------*/
+/*
+** Include the unit tests of the C++ wrapper if it is being built for tests
+**/
+#ifdef CUID_HPP_TESTS
+
+#include "./tests/cuid_hpp_tests.h"
+#endif /* CUID_HPP_TESTS */
+
+#endif /* CUID_HPP */
@@ -0,0 +1,136 @@
+#ifndef CUID_HPP_TESTS_H
+#include "./munit.h" // The external unit tests framework - µnit
+#include <cstring> // std::strlen, std::memcmp
+#include <set> // std::set
+#include <type_traits> // std::is_copy_constructible
+#include <unordered_set> // std::unordered_set
+#include <utility> // std::move
+#include <vector> // std::vector
+
+// The fixed encoders are usable at compile time
+static constexpr std::array<char, 3>
+cuid_hpp_encode_3k() {
+  std::array<char, 3> result{};
+  cuidpp::encode_base36<3>(128, result.data());
+  return result;
+}
+static_assert(cuid_hpp_encode_3k()[0] == '0'
+              && cuid_hpp_encode_3k()[1] == '3'
+              && cuid_hpp_encode_3k()[2] == 'k',
+              "encode_base36 is evaluated at compile time");
+static_assert(cuidpp::layout<>::size == CUID_SIZE,
+              "The default layout is the layout of cuid.h");
+static_assert(!std::is_copy_constructible_v<cuidpp::generator<>>
+              && !std::is_copy_constructible_v<cuidpp::pure_generator>
+              && std::is_nothrow_move_constructible_v<cuidpp::pure_generator>,
+              "The generators are move-only");
+
+/*
+** Test that the fixed width encoders match `cuid_base36_fixed`.
+*/
+static MunitResult
+test_encode_base36(const MunitParameter params[], void* data) {
+    std::uint64_t const numbers[] = { 0, 35, 36, 1295, 1296, 1679615,
+                                      2176782335ULL, 4738381338321616895ULL };
+    for (std::uint64_t number : numbers) {
+        char expected[12] = {0};
+        char result[12] = {0};
+        cuid_base36_fixed(number, expected, 12);
+        cuidpp::encode_base36<12>(number, result);
+        munit_assert_memory_equal(12, result, expected);
+        cuid_base36_fixed(number, expected, 5);
+        cuidpp::encode_base36<5>(number, result);
+        munit_assert_memory_equal(5, result, expected);
+    }
+    return MUNIT_OK;
+}
+
+/*
+** Test that the generators write cuids of their layout.
+*/
+static MunitResult
+test_generator(const MunitParameter params[], void* data) {
+    cuidpp::generator<> default_gen("iPad");
+    char result[CUID_SIZE] = {0};
+    munit_assert_size(default_gen.next(36, result), ==, CUID_SIZE - 1);
+    munit_assert_memory_equal(15, result, "c0000100000iPad");
+
+    using long_layout = cuidpp::layout<8, 6>;
+    cuidpp::generator<long_layout> long_gen("ab12");
+    long_gen.next(1);
+    cuidpp::generator<long_layout>::id_type const id = long_gen.next(1);
+    munit_assert_size(long_layout::size, ==, 1 + 8 + 4 * 6 + 1);
+    munit_assert_size(std::strlen(id.data()), ==, long_layout::size - 1);
+    munit_assert_memory_equal(21, id.data(), "c00000001000001" "00ab12");
+
+    using short_layout = cuidpp::layout<4, 2>;
+    cuidpp::generator<short_layout> short_gen("ab12");
+    cuidpp::basic_id<short_layout::size> const short_id = short_gen.next(37);
+    munit_assert_size(short_layout::size, ==, 14);
+    munit_assert_memory_equal(9, short_id.data(), "c00110012");
+    munit_assert_char(short_id.chars[short_layout::size - 1], ==, '\0');
+    return MUNIT_OK;
+}
+
+/*
+** Test that the pure generator makes valid cuids, survives a move and that
+** its cuids work as the keys of the std containers.
+*/
+static MunitResult
+test_pure_generator(const MunitParameter params[], void* data) {
+    cuidpp::pure_generator gen("iPad", 36);
+    cuidpp::id const first = gen.next(37);
+    munit_assert_size(std::strlen(first.c_str()), ==, CUID_SIZE - 1);
+    munit_assert_memory_equal(7, first.data(), "c000011");
+    munit_assert_memory_equal(4, &first.data()[CUID_FINGERPRINT_OFFSET],
+                              "iPad");
+
+    cuidpp::pure_generator moved = std::move(gen);
+    std::vector<cuidpp::id> ids(16);
+    auto end = moved.generate_n(ids.begin(), ids.size(), 38);
+    munit_assert_true(end == ids.end());
+
+    std::set<cuidpp::id> ordered(ids.begin(), ids.end());
+    std::unordered_set<cuidpp::id> hashed(ids.begin(), ids.end());
+    hashed.insert(first);
+    munit_assert_size(ordered.size(), ==, ids.size());
+    munit_assert_size(hashed.size(), ==, ids.size() + 1);
+    munit_assert_true(ids[0] == ids[0]);
+    munit_assert_true(ids[0] != first);
+    // Compares as strcmp
+    munit_assert_true((first < ids[0])
+                      == (std::strcmp(first.c_str(), ids[0].c_str()) < 0));
+    munit_assert_true(first.view() == std::string_view(first.c_str()));
+    munit_assert_true(std::hash<cuidpp::id>{}(first)
+                      == cuid_hash(first.data()));
+    munit_assert_int(cuidpp::id::compare(first, first), ==, 0);
+    return MUNIT_OK;
+}
+
+/*
+** The main() function is included to be able to run the C++ wrapper tests
+** directly in the CLI.
+*/
+int main(int argc, char* argv[]) {
+    static MunitTest all_tests[] = {
+        { (char*) "test_encode_base36",
+          test_encode_base36,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+        { (char*) "test_generator",
+          test_generator,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+        { (char*) "test_pure_generator",
+          test_pure_generator,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+        { NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+    };
+    const MunitSuite test_suite = {
+        (char*) "cuid.hpp/",
+        all_tests,
+        NULL,
+        1,
+        MUNIT_SUITE_OPTION_NONE
+    };
+    return munit_suite_main(&test_suite, (void*) "munit", argc, argv);
+}
+#endif /* CUID_HPP_TESTS_H */
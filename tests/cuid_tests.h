@@ -1,5 +1,32 @@
 #ifndef CUID_TESTS_H
 #include "./munit.h" // The external unit tests framework - µnit
+#ifdef CUID_THREADS
+#include <pthread.h> // pthread_create, pthread_join
+#endif
+#if defined(CUID_FORK_SAFE) || defined(CUID_BUFFERED_RANDOM)
+#include <sys/wait.h> // waitpid
+#endif
+#ifdef CUID_ORDERED
+#include <stdlib.h> // qsort
+#endif
+
+/*
+** Writes into `result` the cuid of the configured layout that has the lowest
+** CUID_TIMESTAMP_LENGTH base36 digits of `timestamp`, zero padded, followed
+** by the 16 chars of the counter, fingerprint and random `blocks`.
+** The tests build their fixtures with it instead of hard-coding cuids of
+** the default 6 chars timestamp.
+*/
+static void
+cuid_tests_fixture(char result[CUID_SIZE], uint64_t const timestamp,
+                   char const blocks[4 * CUID_BLOCK_LENGTH + 1]) {
+    char digits[CUID_BASE36_RESULT_SIZE] = {0};
+    cuid_base36_pad(timestamp, digits, CUID_TIMESTAMP_LENGTH, '0');
+    result[0] = 'c';
+    memcpy(&result[CUID_TIMESTAMP_OFFSET], digits, CUID_TIMESTAMP_LENGTH);
+    memcpy(&result[CUID_COUNTER_OFFSET], blocks, 4 * CUID_BLOCK_LENGTH);
+    result[CUID_SIZE - 1] = '\0';
+}
 
 /*
 ** Test that the `cuid_t` exists
@@ -13,15 +40,23 @@ test_id_exists(const MunitParameter params[], void* data) {
 }
 
 /*
-** Test that the `cuid_t` has a fingerprint attribute.
+** Test that the `cuid_t` has room for the fingerprint block in its value.
 */
 static MunitResult
 test_fingerprint_exists(const MunitParameter params[], void* data) {
     cuid_t id = {0};
-    
-    munit_assert_not_null(&id.cuid_fingerprint);
-    // Should have enough space for a base36 string
-    munit_assert_uint(sizeof(id.cuid_fingerprint), ==, CUID_BASE36_RESULT_SIZE);
+
+    munit_assert_size(CUID_FINGERPRINT_OFFSET, ==,
+                      1 + CUID_TIMESTAMP_LENGTH + CUID_BLOCK_LENGTH);
+    munit_assert_size(CUID_SIZE, ==,
+                      2 + CUID_TIMESTAMP_LENGTH + 4 * CUID_BLOCK_LENGTH);
+    munit_assert_size(CUID_FINGERPRINT_OFFSET + CUID_BLOCK_LENGTH, <,
+                      sizeof(id.cuid_value));
+#if defined(CUID_RANDOM_PCG32) && !defined(CUID_FORK_SAFE) \
+    && !defined(CUID_STATS)
+    // With a compact PRNG the whole state fits in a cache line
+    munit_assert_size(sizeof(cuid_t), <=, 64);
+#endif
     return MUNIT_OK;
 }
 
@@ -108,6 +143,140 @@ test_padded_base36(const MunitParameter params[], void* data) {
     return MUNIT_OK;
 }
 
+/*
+** Test that the fixed width base36 encoders write exactly the requested
+** digits, matching the variable length `cuid_base36` output.
+*/
+static MunitResult
+test_fixed_base36(const MunitParameter params[], void* data) {
+    char result[CUID_BASE36_RESULT_SIZE] = {0};
+    munit_assert_size(cuid_base36(UINT64_MAX, result), ==, 13);
+    munit_assert_string_equal(result, "3w5e11264sgsf");
+
+    // The 4 char blocks keep the last 4 digits
+    char block[5] = {0};
+    cuid_base36_block(UINT32_MAX, block);
+    munit_assert_string_equal(block, "41z3");
+    cuid_base36_block(36 * 36 * 36 * 36, block);
+    munit_assert_string_equal(block, "0000");
+    cuid_base36_block(0, block);
+    munit_assert_string_equal(block, "0000");
+
+    // Fixed widths do not write past the width
+    char fixed[8] = "xxxxxxx";
+    cuid_base36_fixed(123456789, fixed, 6);
+    munit_assert_string_equal(fixed, "21i3v9x");
+    cuid_base36_fixed(35, fixed, 1);
+    munit_assert_string_equal(fixed, "z1i3v9x");
+
+    // Blocks and padding match the unpadded conversion for random numbers
+    for (size_t i = 0; i < 10000; ++i) {
+      uint32_t const number = munit_rand_uint32();
+      char expected[CUID_BASE36_RESULT_SIZE] = {0};
+      size_t const length = cuid_base36(number, expected);
+      char padded[CUID_BASE36_RESULT_SIZE] = {0};
+      cuid_base36_pad(number, padded, 8, '0');
+      munit_assert_string_equal(&padded[8 - length], expected);
+      cuid_base36_block(number, block);
+      munit_assert_memory_equal(4, block, &padded[4]);
+    }
+
+    return MUNIT_OK;
+}
+
+/*
+** Test that the batch base36 blocks match `cuid_base36_block` for each of
+** the available implementations.
+*/
+static void
+cuid_tests_check_blocks(void (*blocks)(uint32_t const *, size_t, char *,
+                                       size_t),
+                        uint32_t const *values, size_t n) {
+    char expected[64][5] = {{0}};
+    char result[64][5] = {{0}};
+    cuid_base36_blocks_scalar(values, n, expected[0], 5);
+    blocks(values, n, result[0], 5);
+    for (size_t i = 0; i < n; ++i) {
+      char block[5] = {0};
+      cuid_base36_block(values[i], block);
+      munit_assert_string_equal(expected[i], block);
+      munit_assert_string_equal(result[i], block);
+    }
+}
+
+static MunitResult
+test_base36_blocks(const MunitParameter params[], void* data) {
+    // Edge values followed by random ones, 37 values to also test the tails
+    uint32_t values[37] = {
+      0, 1, 35, 36, 1295, 1296, 1679615, 1679616, UINT32_MAX, UINT32_MAX - 1
+    };
+    for (size_t i = 10; i < 37; ++i) {
+      values[i] = munit_rand_uint32();
+    }
+    cuid_tests_check_blocks(cuid_base36_blocks, values, 37);
+#if defined(CUID_SIMD_X86)
+    cuid_tests_check_blocks(cuid_base36_blocks_sse2, values, 37);
+    if (__builtin_cpu_supports("avx2")) {
+      cuid_tests_check_blocks(cuid_base36_blocks_avx2, values, 37);
+    }
+#elif defined(CUID_SIMD_NEON)
+    cuid_tests_check_blocks(cuid_base36_blocks_neon, values, 37);
+#endif
+
+    return MUNIT_OK;
+}
+
+/*
+** Test that each supported CPU level can be selected, and that its kernels
+** give the same results as the scalar ones.
+*/
+static MunitResult
+test_cpu_dispatch(const MunitParameter params[], void* data) {
+    int const selected = cuid_cpu_level();
+    munit_assert_int(cuid_cpu_supports(selected), ==, 1);
+    munit_assert_int(cuid_cpu_supports(CUID_CPU_SCALAR), ==, 1);
+    munit_assert_int(cuid_set_cpu_level(CUID_CPU_LEVELS), ==, 0);
+    munit_assert_null(cuid_cpu_level_name(-1));
+
+    uint32_t values[37] = { 0, 35, 36, 1679615, UINT32_MAX };
+    for (size_t i = 5; i < 37; ++i) {
+      values[i] = munit_rand_uint32();
+    }
+    char valid[CUID_SIZE] = {0};
+    cuid(valid);
+    char invalid[CUID_SIZE] = {0};
+    memcpy(invalid, valid, CUID_SIZE);
+    invalid[CUID_SIZE - 3] = 'A';
+    for (int level = 0; level < CUID_CPU_LEVELS; ++level) {
+      if (!cuid_set_cpu_level(level)) {
+        munit_assert_int(cuid_cpu_supports(level), ==, 0);
+        continue;
+      }
+      munit_assert_int(cuid_cpu_level(), ==, level);
+      cuid_tests_check_blocks(cuid_base36_blocks, values, 37);
+      munit_assert_int(cuid_validate(valid), ==, 1);
+      munit_assert_int(cuid_validate(invalid), ==, 0);
+    }
+
+    // Forced by the environment variable, unless it names no usable level
+    char forced[16] = {0};
+    char const *env = getenv(CUID_CPU_LEVEL_ENV);
+    strncpy(forced, env != 0x0 ? env : "", sizeof(forced) - 1);
+    setenv(CUID_CPU_LEVEL_ENV, "scalar", 1);
+    munit_assert_int(cuid_cpu_detect_level(), ==, CUID_CPU_SCALAR);
+    setenv(CUID_CPU_LEVEL_ENV, "unknown", 1);
+    munit_assert_int(cuid_cpu_supports(cuid_cpu_detect_level()), ==, 1);
+    if (env != 0x0) {
+      setenv(CUID_CPU_LEVEL_ENV, forced, 1);
+    } else {
+      unsetenv(CUID_CPU_LEVEL_ENV);
+    }
+    munit_assert_string_equal(cuid_cpu_level_name(cuid_cpu_detect_level()),
+                              cuid_cpu_level_name(selected));
+    munit_assert_int(cuid_set_cpu_level(selected), ==, 1);
+    return MUNIT_OK;
+}
+
 /*
 ** Test that a default counter implementation exists and works as
 ** expected.
@@ -169,6 +338,42 @@ test_timestamp(const MunitParameter params[], void* data) {
     return MUNIT_OK;
 }
 
+/*
+** Test that the timestamp cache only encodes newer timestamps.
+*/
+static MunitResult
+test_timestamp_cache(const MunitParameter params[], void* data) {
+    cuid_timestamp_cache_t cache = CUID_TIMESTAMP_CACHE_INIT;
+    char first[CUID_SIZE] = {0};
+    char newer[CUID_SIZE] = {0};
+    cuid_tests_fixture(first, 123456789, "0000000000000000");
+    cuid_tests_fixture(newer, 223456789, "0000000000000000");
+    munit_assert_int(cuid_timestamp_cache_update(&cache, 123456789), ==, 1);
+    munit_assert_memory_equal(CUID_TIMESTAMP_LENGTH, cache.block,
+                              &first[CUID_TIMESTAMP_OFFSET]);
+    // The same timestamp keeps the cached block
+    munit_assert_int(cuid_timestamp_cache_update(&cache, 123456789), ==, 0);
+    // Older timestamps do not move the cache backwards
+    munit_assert_int(cuid_timestamp_cache_update(&cache, 123456788), ==, 0);
+    munit_assert_memory_equal(CUID_TIMESTAMP_LENGTH, cache.block,
+                              &first[CUID_TIMESTAMP_OFFSET]);
+    munit_assert_ulong(cache.value, ==, 123456789);
+    // Newer ones are encoded
+    munit_assert_int(cuid_timestamp_cache_update(&cache, 223456789), ==, 1);
+    munit_assert_memory_equal(CUID_TIMESTAMP_LENGTH, cache.block,
+                              &newer[CUID_TIMESTAMP_OFFSET]);
+
+#ifdef CLOCK_REALTIME
+    // The coarse clock is close to `time()`
+    unsigned long const coarse = cuid_get_timestamp_coarse();
+    unsigned long const now = (unsigned long)time(0x0);
+    munit_assert_ulong(coarse + 1, >=, now);
+    munit_assert_ulong(coarse, <=, now);
+#endif
+
+    return MUNIT_OK;
+}
+
 /*
 ** Test that a fingerprint can be generated.
 */
@@ -233,6 +438,43 @@ test_has_random(const MunitParameter params[], void* data) {
   return MUNIT_OK;
 }
 
+/*
+** Test that the compact PCG32 random implementation works as the default
+** random implementation, and that it can peek at its next number.
+*/
+static MunitResult
+test_pcg32(const MunitParameter params[], void* data) {
+  cuid_pcg32_t random1 = cuid_pcg32_init(cuid_pcg32_create());
+  munit_assert_size(sizeof(random1), <=, 24);
+
+  uint32_t rnd_value1 = cuid_pcg32_read(random1);
+  munit_assert_uint32(cuid_pcg32_read(random1), ==, rnd_value1);
+
+  // Peeking returns the next number without changing the state
+  uint32_t rnd_peek = cuid_pcg32_peek_ptr(&random1);
+  munit_assert_uint32(cuid_pcg32_read(random1), ==, rnd_value1);
+  random1 = cuid_pcg32_next(random1);
+  uint32_t rnd_value2 = cuid_pcg32_read(random1);
+  munit_assert_uint32(rnd_value2, ==, rnd_peek);
+  munit_assert_uint32(rnd_value2, !=, rnd_value1);
+
+  // Initializing replays the same sequence
+  cuid_pcg32_init_ptr(&random1);
+  munit_assert_uint32(cuid_pcg32_read_ptr(&random1), ==, rnd_value1);
+  cuid_pcg32_next_ptr(&random1);
+  munit_assert_uint32(cuid_pcg32_read_ptr(&random1), ==, rnd_value2);
+
+  // Known answer from the PCG32 reference implementation (demo seed 42, 54)
+  cuid_pcg32_t reference = { .pcg_inc = (54U << 1U) | 1U };
+  reference.pcg_state = (reference.pcg_inc + 42U) * CUID_PCG32_MULTIPLIER
+                      + reference.pcg_inc;
+  munit_assert_uint32(cuid_pcg32_read_ptr(&reference), ==, 0xa15c02b7);
+  cuid_pcg32_next_ptr(&reference);
+  munit_assert_uint32(cuid_pcg32_read_ptr(&reference), ==, 0x7b47f409);
+
+  return MUNIT_OK;
+}
+
 /*
 ** Test that the `cuid()` function works as expected.
 */
@@ -240,25 +482,32 @@ static MunitResult
 test_cuid(const MunitParameter params[], void* data) {
     char result[CUID_SIZE] = {0};
     size_t length = 0;
+    unsigned long const before = CUID_GET_TIMESTAMP();
     length = cuid(result);
+    unsigned long const after = CUID_GET_TIMESTAMP();
     munit_logf(MUNIT_LOG_INFO, "cuid: %s", result);
     munit_assert_size(length, >, 0);
     munit_assert_char(result[0], ==, 'c');
 
-    char timestamp_result[CUID_BASE36_RESULT_SIZE] = {0};
-    size_t timestamp_length = cuid_base36(CUID_GET_TIMESTAMP(),
-                                          timestamp_result);
-    // The timestamp must be available at the CUID
-    munit_logf(MUNIT_LOG_INFO, "timestamp: %s", timestamp_result);
-    for (size_t i = 0; i < timestamp_length; ++i) {
-      munit_assert_char(result[1 + i], ==, timestamp_result[i]);
-    }
+    // The timestamp must be available at the CUID, as its lowest digits
+    char timestamp_before[CUID_SIZE] = {0};
+    char timestamp_after[CUID_SIZE] = {0};
+    cuid_tests_fixture(timestamp_before, before, "0000000000000000");
+    cuid_tests_fixture(timestamp_after, after, "0000000000000000");
+    munit_logf(MUNIT_LOG_INFO, "timestamp: %s", timestamp_before);
+    munit_assert_true(
+      memcmp(&result[CUID_TIMESTAMP_OFFSET],
+             &timestamp_before[CUID_TIMESTAMP_OFFSET],
+             CUID_TIMESTAMP_LENGTH) == 0
+      || memcmp(&result[CUID_TIMESTAMP_OFFSET],
+                &timestamp_after[CUID_TIMESTAMP_OFFSET],
+                CUID_TIMESTAMP_LENGTH) == 0);
 
     // Counter should start as 1
     char counter_result[CUID_BASE36_RESULT_SIZE] = {0};
     size_t counter_length = cuid_base36_pad(1, counter_result, 4, '0');
     for (size_t i = 0; i < counter_length; ++i) {
-      munit_assert_char(result[1 + timestamp_length + i], ==, counter_result[i]);
+      munit_assert_char(result[CUID_COUNTER_OFFSET + i], ==, counter_result[i]);
     }
 
     // Fingerprint should have 4 chars
@@ -268,7 +517,7 @@ test_cuid(const MunitParameter params[], void* data) {
     munit_logf(MUNIT_LOG_INFO, "fingerprint: %s", fingerprint_result);
     // Fingerprint should be present
     for (size_t i = 0; i < fingerprint_length; ++i) {
-      munit_assert_char(result[1 + timestamp_length + counter_length + i],
+      munit_assert_char(result[CUID_FINGERPRINT_OFFSET + i],
           ==, fingerprint_result[i]);
     }
     // The last 8 chars should be different
@@ -287,12 +536,309 @@ test_cuid(const MunitParameter params[], void* data) {
     munit_assert_size(sum1, !=, sum2);
 
     // The counter should be increased
-    munit_logf(MUNIT_LOG_INFO, "counter1: %c; counter2: %c", result[1 + timestamp_length + 3], result2[1 + timestamp_length + 3]);
-    munit_assert_char(result[1 + timestamp_length + 3], !=, result2[1 + timestamp_length + 3]);
+    munit_logf(MUNIT_LOG_INFO, "counter1: %c; counter2: %c",
+               result[CUID_COUNTER_OFFSET + 3],
+               result2[CUID_COUNTER_OFFSET + 3]);
+    munit_assert_char(result[CUID_COUNTER_OFFSET + 3], !=,
+                      result2[CUID_COUNTER_OFFSET + 3]);
+
+    return MUNIT_OK;
+}
+
+/*
+** Test that the fingerprint cached by `cuid()` matches the fingerprint
+** function, before and after the cache is reset.
+*/
+static MunitResult
+test_fingerprint_cache(const MunitParameter params[], void* data) {
+    char fingerprint[CUID_FINGERPRINT_SIZE] = {0};
+    size_t fingerprint_length = CUID_GET_FINGERPRINT(fingerprint);
+
+    char result1[CUID_SIZE] = {0};
+    char result2[CUID_SIZE] = {0};
+    cuid(result1);
+    cuid_fingerprint_reset();
+    cuid(result2);
+    munit_logf(MUNIT_LOG_INFO, "cuid1: %s; cuid2: %s", result1, result2);
+    for (size_t i = 0; i < fingerprint_length; ++i) {
+      munit_assert_char(result1[CUID_FINGERPRINT_OFFSET + i], ==,
+                        fingerprint[i]);
+      munit_assert_char(result2[CUID_FINGERPRINT_OFFSET + i], ==,
+                        fingerprint[i]);
+    }
 
     return MUNIT_OK;
 }
 
+#ifdef CUID_THREADS
+/*
+** The per-thread work for `test_cuid_threads`, generates cuids and keeps
+** their counter values in the array passed as argument.
+*/
+#define CUID_TESTS_THREADS 4
+#define CUID_TESTS_PER_THREAD 3000
+static void *
+cuid_tests_thread(void *arg) {
+    uint32_t *counters = arg;
+    for (size_t n = 0; n < CUID_TESTS_PER_THREAD; ++n) {
+      char result[CUID_SIZE] = {0};
+      cuid(result);
+      cuid_parts_t parts = {0};
+      munit_assert_int(cuid_parse(result, &parts), ==, 1);
+      counters[n] = parts.counter;
+    }
+    return 0x0;
+}
+
+/*
+** Test that `cuid()` counters are unique across threads.
+*/
+static MunitResult
+test_cuid_threads(const MunitParameter params[], void* data) {
+    static uint32_t counters[CUID_TESTS_THREADS][CUID_TESTS_PER_THREAD];
+    pthread_t threads[CUID_TESTS_THREADS];
+    for (size_t t = 0; t < CUID_TESTS_THREADS; ++t) {
+      pthread_create(&threads[t], 0x0, cuid_tests_thread, counters[t]);
+    }
+    for (size_t t = 0; t < CUID_TESTS_THREADS; ++t) {
+      pthread_join(threads[t], 0x0);
+    }
+    // Mark every counter seen, none should be seen twice
+    static uint8_t seen[36 * 36 * 36 * 36];
+    for (size_t t = 0; t < CUID_TESTS_THREADS; ++t) {
+      for (size_t n = 0; n < CUID_TESTS_PER_THREAD; ++n) {
+        munit_assert_uint8(seen[counters[t][n]], ==, 0);
+        seen[counters[t][n]] = 1;
+      }
+    }
+
+    return MUNIT_OK;
+}
+
+/*
+** The per-thread work for `test_shared`, checks that the cuids of a thread
+** increase and keeps their timestamp and counter values, as an index of the
+** `seen` array of `test_shared`.
+*/
+#define CUID_TESTS_SHARED_TICKS (CUID_TESTS_PER_THREAD / 1000)
+static cuid_shared_t cuid_tests_shared;
+static void *
+cuid_tests_shared_thread(void *arg) {
+    uint32_t *counters = arg;
+    char previous[CUID_SIZE] = {0};
+    for (size_t n = 0; n < CUID_TESTS_PER_THREAD; ++n) {
+      char result[CUID_SIZE] = {0};
+      cuid_shared_next(&cuid_tests_shared, 1234567 + n / 1000, result);
+      munit_assert_int(strcmp(previous, result), <, 0);
+      memcpy(previous, result, CUID_SIZE);
+      cuid_parts_t parts = {0};
+      munit_assert_int(cuid_parse(result, &parts), ==, 1);
+      munit_assert_uint64(parts.timestamp - 1234567, <,
+                          CUID_TESTS_SHARED_TICKS);
+      counters[n] = (uint32_t)(parts.timestamp - 1234567)
+        * CUID_TESTS_THREADS * CUID_TESTS_PER_THREAD + parts.counter;
+    }
+    return 0x0;
+}
+
+static MunitResult
+test_shared(const MunitParameter params[], void* data) {
+    cuid_shared_init(&cuid_tests_shared, "abcd");
+    char first[CUID_SIZE] = {0};
+    char second[CUID_SIZE] = {0};
+    char expected[CUID_SIZE] = {0};
+    cuid_shared_next(&cuid_tests_shared, 100, first);
+    cuid_tests_fixture(expected, 100, "0000abcd00000000");
+    munit_assert_memory_equal(CUID_RANDOM1_OFFSET, first, expected);
+    // The timestamp does not go back, the cuids keep increasing
+    cuid_shared_next(&cuid_tests_shared, 99, second);
+    cuid_tests_fixture(expected, 100, "0001abcd00000000");
+    munit_assert_memory_equal(CUID_RANDOM1_OFFSET, second, expected);
+    // A newer timestamp starts the counter again
+    cuid_shared_next(&cuid_tests_shared, 101, second);
+    cuid_tests_fixture(expected, 101, "0000abcd00000000");
+    munit_assert_memory_equal(CUID_RANDOM1_OFFSET, second, expected);
+    munit_assert_int(strcmp(first, second), <, 0);
+
+    // Past 36^4 cuids in a timestamp the generator moves on to the next one
+    memcpy(first, second, CUID_SIZE);
+    for (uint32_t i = 0; i < CUID_COUNTER_MAX + 10; ++i) {
+      cuid_shared_next(&cuid_tests_shared, 101, second);
+      munit_assert_int(strcmp(first, second), <, 0);
+      memcpy(first, second, CUID_SIZE);
+    }
+    cuid_parts_t parts = {0};
+    munit_assert_int(cuid_parse(second, &parts), ==, 1);
+    munit_assert_uint64(parts.timestamp, ==, 102);
+    munit_assert_uint32(parts.counter, ==, 10);
+
+    cuid_shared_init(&cuid_tests_shared, "abcd");
+    static uint32_t counters[CUID_TESTS_THREADS][CUID_TESTS_PER_THREAD];
+    pthread_t threads[CUID_TESTS_THREADS];
+    for (size_t t = 0; t < CUID_TESTS_THREADS; ++t) {
+      pthread_create(&threads[t], 0x0, cuid_tests_shared_thread, counters[t]);
+    }
+    for (size_t t = 0; t < CUID_TESTS_THREADS; ++t) {
+      pthread_join(threads[t], 0x0);
+    }
+    // No two cuids have the same timestamp and counter
+    static uint8_t seen[CUID_TESTS_SHARED_TICKS * CUID_TESTS_THREADS
+                        * CUID_TESTS_PER_THREAD];
+    for (size_t t = 0; t < CUID_TESTS_THREADS; ++t) {
+      for (size_t n = 0; n < CUID_TESTS_PER_THREAD; ++n) {
+        munit_assert_uint32(counters[t][n], <, sizeof seen);
+        munit_assert_uint8(seen[counters[t][n]], ==, 0);
+        seen[counters[t][n]] = 1;
+      }
+    }
+    return MUNIT_OK;
+}
+
+/*
+** The per-thread work for `test_pool`, pops cuids from the pool and keeps
+** their counter values.
+** With CUID_ORDERED the counter starts again at each millisecond, so the
+** whole cuids are kept instead, and the ones of a thread must come out of
+** the pool in order.
+*/
+static cuid_pool_t cuid_tests_pool;
+#ifdef CUID_ORDERED
+static int
+cuid_tests_strcmp(void const *a, void const *b) {
+    return strcmp(a, b);
+}
+#endif /* CUID_ORDERED */
+static void *
+cuid_tests_pool_thread(void *arg) {
+#ifdef CUID_ORDERED
+    char (*cuids)[CUID_SIZE] = arg;
+#else
+    uint32_t *counters = arg;
+#endif /* CUID_ORDERED */
+    for (size_t n = 0; n < CUID_TESTS_PER_THREAD; ++n) {
+      char result[CUID_SIZE] = {0};
+      while (!cuid_pool_pop(&cuid_tests_pool, result)) {
+        // Wait for the producer
+      }
+#ifdef CUID_ORDERED
+      munit_assert_true(n == 0 || strcmp(cuids[n - 1], result) < 0);
+      memcpy(cuids[n], result, CUID_SIZE);
+#else
+      cuid_parts_t parts = {0};
+      munit_assert_int(cuid_parse(result, &parts), ==, 1);
+      counters[n] = parts.counter;
+#endif /* CUID_ORDERED */
+    }
+    return 0x0;
+}
+
+static MunitResult
+test_pool(const MunitParameter params[], void* data) {
+    static cuid_pool_slot_t slots[256];
+    char fingerprint[CUID_FINGERPRINT_SIZE] = "abcd";
+    munit_assert_int(
+      cuid_pool_init(&cuid_tests_pool, slots, 100, 10, fingerprint), ==, 0);
+    munit_assert_int(
+      cuid_pool_init(&cuid_tests_pool, slots, 256, 256, fingerprint), ==, 0);
+    munit_assert_int(
+      cuid_pool_init(&cuid_tests_pool, slots, 256, 64, fingerprint), ==, 1);
+    // Stopping a pool that was not started does nothing
+    cuid_pool_stop(&cuid_tests_pool);
+
+    // Refilled by hand, the cuids come out in order
+    char result[CUID_SIZE] = {0};
+    munit_assert_int(cuid_pool_pop(&cuid_tests_pool, result), ==, 0);
+    munit_assert_size(cuid_pool_refill(&cuid_tests_pool, 1000), ==, 256);
+    munit_assert_size(cuid_pool_size(&cuid_tests_pool), ==, 256);
+    munit_assert_size(cuid_pool_refill(&cuid_tests_pool, 1000), ==, 0);
+    char previous[CUID_SIZE] = {0};
+    for (size_t i = 0; i < 200; ++i) {
+      munit_assert_int(cuid_pool_pop(&cuid_tests_pool, result), ==, 1);
+      munit_assert_int(strcmp(previous, result), <, 0);
+      memcpy(previous, result, CUID_SIZE);
+    }
+    munit_assert_size(cuid_pool_refill(&cuid_tests_pool, 1000), ==, 200);
+
+    // Refilled by the producer while being popped from many threads
+    munit_assert_int(cuid_pool_start(&cuid_tests_pool), ==, 1);
+    pthread_t threads[CUID_TESTS_THREADS];
+#ifdef CUID_ORDERED
+    size_t const total = CUID_TESTS_THREADS * CUID_TESTS_PER_THREAD;
+    static char cuids[CUID_TESTS_THREADS * CUID_TESTS_PER_THREAD][CUID_SIZE];
+    for (size_t t = 0; t < CUID_TESTS_THREADS; ++t) {
+      pthread_create(&threads[t], 0x0, cuid_tests_pool_thread,
+                     cuids[t * CUID_TESTS_PER_THREAD]);
+    }
+#else
+    static uint32_t counters[CUID_TESTS_THREADS][CUID_TESTS_PER_THREAD];
+    for (size_t t = 0; t < CUID_TESTS_THREADS; ++t) {
+      pthread_create(&threads[t], 0x0, cuid_tests_pool_thread, counters[t]);
+    }
+#endif /* CUID_ORDERED */
+    for (size_t t = 0; t < CUID_TESTS_THREADS; ++t) {
+      pthread_join(threads[t], 0x0);
+    }
+    cuid_pool_stop(&cuid_tests_pool);
+    cuid_pool_destroy(&cuid_tests_pool);
+#ifdef CUID_ORDERED
+    // No cuid was popped twice
+    qsort(cuids, total, CUID_SIZE, cuid_tests_strcmp);
+    for (size_t i = 1; i < total; ++i) {
+      munit_assert_int(strcmp(cuids[i - 1], cuids[i]), <, 0);
+    }
+#else
+    static uint8_t seen[36 * 36 * 36 * 36];
+    for (size_t t = 0; t < CUID_TESTS_THREADS; ++t) {
+      for (size_t n = 0; n < CUID_TESTS_PER_THREAD; ++n) {
+        munit_assert_uint8(seen[counters[t][n]], ==, 0);
+        seen[counters[t][n]] = 1;
+      }
+    }
+#endif /* CUID_ORDERED */
+    return MUNIT_OK;
+}
+#endif /* CUID_THREADS */
+
+/*
+** Test that the buffered random numbers are refilled when used up and
+** discarded by `cuid_random_reset()`.
+*/
+static MunitResult
+test_buffered_random(const MunitParameter params[], void* data) {
+#ifdef CUID_BUFFERED_RANDOM
+    uint32_t first = cuid_buffered_rand32();
+    munit_assert_size(cuid_random_position, ==, 1);
+    munit_assert_uint32(cuid_random_buffer[0], ==, first);
+    // Use the rest of the buffer, the numbers should not all be the same
+    size_t equal = 0;
+    for (size_t i = 1; i < CUID_RANDOM_BUFFER_LENGTH; ++i) {
+      equal += cuid_buffered_rand32() == first;
+    }
+    munit_assert_size(equal, <, CUID_RANDOM_BUFFER_LENGTH - 1);
+    // The next number refills the buffer
+    cuid_buffered_rand32();
+    munit_assert_size(cuid_random_position, ==, 1);
+    // Resetting discards the numbers left
+    cuid_random_reset();
+    munit_assert_size(cuid_random_position, ==, CUID_RANDOM_BUFFER_LENGTH);
+    cuid_buffered_rand32();
+    munit_assert_size(cuid_random_position, ==, 1);
+#ifdef CUID_ATFORK
+    // A child process does not take the numbers left by its parent
+    pid_t const child = fork();
+    munit_assert_int(child, >=, 0);
+    if (child == 0) {
+      _exit(cuid_random_position == CUID_RANDOM_BUFFER_LENGTH ? 0 : 1);
+    }
+    int status = 1;
+    munit_assert_int(waitpid(child, &status, 0), ==, child);
+    munit_assert_true(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    munit_assert_size(cuid_random_position, ==, 1);
+#endif /* CUID_ATFORK */
+#endif /* CUID_BUFFERED_RANDOM */
+    return MUNIT_OK;
+}
+
 /*
 ** Test that the `cuid_create()` function works as expected.
 */
@@ -304,14 +850,18 @@ test_create(const MunitParameter params[], void* data) {
 
     // Should set the fingerprint
     munit_logf(MUNIT_LOG_INFO, "fingerprint: %s", fingerprint_result);
-    // Fingerprint should be present
+    // Fingerprint should be present in its block
     for (size_t i = 0; i < fingerprint_length; ++i) {
-      munit_assert_char(id.cuid_fingerprint[i], ==, fingerprint_result[i]);
+      munit_assert_char(id.cuid_value[CUID_FINGERPRINT_OFFSET + i], ==,
+                        fingerprint_result[i]);
     }
 
-    // Should start with cuid_value as 0
+    // Should start with the rest of cuid_value as 0
     for (size_t i = 0; i < CUID_SIZE; ++i) {
-      munit_assert_char(id.cuid_value[i], ==, 0);
+      if (i < CUID_FINGERPRINT_OFFSET
+          || i >= CUID_FINGERPRINT_OFFSET + CUID_BLOCK_LENGTH) {
+        munit_assert_char(id.cuid_value[i], ==, 0);
+      }
     }
 
     return MUNIT_OK;
@@ -327,8 +877,8 @@ test_init(const MunitParameter params[], void* data) {
     cuid_t id = cuid_create(fingerprint_result);
 
     unsigned long const timestamp = 123456789;
-    // Set a value, to make sure it is cleared after
-    id.cuid_value[0] = 'c';
+    // Set a value, to make sure it is overwritten after
+    id.cuid_value[CUID_COUNTER_OFFSET] = 'x';
 
     id = cuid_init(id, timestamp);
 
@@ -337,20 +887,21 @@ test_init(const MunitParameter params[], void* data) {
     munit_assert_uint(counter_value, ==, 0);
 
     // Random should return a pure random number
-    uint32_t rnd_value = CUID_READ_RANDOM(id.cuid_rnd1);
+    uint32_t rnd_value = cuid_read_random1_ptr(&id);
     munit_assert_uint32(rnd_value, >, 0);
-    uint32_t rnd_value2 = CUID_READ_RANDOM(id.cuid_rnd1);
+    uint32_t rnd_value2 = cuid_read_random1_ptr(&id);
     munit_assert_uint32(rnd_value, ==, rnd_value2);
-    uint32_t rnd_value3 = CUID_READ_RANDOM(id.cuid_rnd2);
+    uint32_t rnd_value3 = cuid_read_random2_ptr(&id);
     munit_assert_uint32(rnd_value, >, 0);
-    uint32_t rnd_value4 = CUID_READ_RANDOM(id.cuid_rnd2);
+    uint32_t rnd_value4 = cuid_read_random2_ptr(&id);
     munit_assert_uint32(rnd_value3, ==, rnd_value4);
 
     // Timestamp should be set as a base36 string of the provided number
-    char expected_timestamp[] = "21i3v9";
-    munit_logf(MUNIT_LOG_INFO, "timestamp: %s", id.cuid_timestamp);
+    char expected[CUID_SIZE] = {0};
+    cuid_tests_fixture(expected, timestamp, "0000000000000000");
     for (size_t i = 0; i < CUID_TIMESTAMP_LENGTH; ++i) {
-      munit_assert_char(id.cuid_timestamp[i], ==, expected_timestamp[i]);
+      munit_assert_char(id.cuid_value[CUID_TIMESTAMP_OFFSET + i], ==,
+                        expected[CUID_TIMESTAMP_OFFSET + i]);
     }
 
     // Value should have the new string
@@ -358,15 +909,17 @@ test_init(const MunitParameter params[], void* data) {
     for (size_t i = 0; i < CUID_SIZE - 1; ++i) {
       munit_assert_char(id.cuid_value[i], !=, 0);
     }
-    // First chars should be "c21i3v90000"
-    munit_assert_char(id.cuid_value[0], ==, 'c');
+    // First chars should be "c21i3v90000" (with the default layout)
+    munit_assert_memory_equal(CUID_FINGERPRINT_OFFSET, id.cuid_value,
+                              expected);
 
     size_t fingerprint_length = CUID_GET_FINGERPRINT(fingerprint_result);
     munit_assert_size(fingerprint_length, ==, 4);
     munit_logf(MUNIT_LOG_INFO, "fingerprint: %s", fingerprint_result);
     // Fingerprint should be present
     for (size_t i = 0; i < fingerprint_length; ++i) {
-      munit_assert_char(id.cuid_fingerprint[i], ==, fingerprint_result[i]);
+      munit_assert_char(id.cuid_value[CUID_FINGERPRINT_OFFSET + i], ==,
+                        fingerprint_result[i]);
     }
 
     return MUNIT_OK;
@@ -384,8 +937,9 @@ test_read(const MunitParameter params[], void* data) {
     char cuid1[CUID_SIZE] = {0};
     cuid_read(id, cuid1);
     munit_logf(MUNIT_LOG_INFO, "cuid1: %s", cuid1);
-    char expected_cuid1[] = "c21i3v90000fing";
-    for (size_t i = 0; i < sizeof(expected_cuid1) - 1; ++i) {
+    char expected_cuid1[CUID_SIZE] = {0};
+    cuid_tests_fixture(expected_cuid1, 123456789, "0000fing00000000");
+    for (size_t i = 0; i < CUID_RANDOM1_OFFSET; ++i) {
       munit_assert_char(cuid1[i], ==, expected_cuid1[i]);
     }
 
@@ -399,14 +953,971 @@ test_read(const MunitParameter params[], void* data) {
     char cuid2[CUID_SIZE] = {0};
     cuid_read(id, cuid2);
     munit_logf(MUNIT_LOG_INFO, "cuid2: %s", cuid2);
-    char expected_cuid2[] = "c3p1gd10001fing";
-    for (size_t i = 0; i < sizeof(expected_cuid2) - 1; ++i) {
+    char expected_cuid2[CUID_SIZE] = {0};
+    cuid_tests_fixture(expected_cuid2, 223456789, "0001fing00000000");
+    for (size_t i = 0; i < CUID_RANDOM1_OFFSET; ++i) {
       munit_assert_char(cuid2[i], ==, expected_cuid2[i]);
     }
 
     return MUNIT_OK;
 }
 
+/*
+** Test that the in-place pointer API produces the same cuids as the value API.
+*/
+static MunitResult
+test_inplace(const MunitParameter params[], void* data) {
+    cuid_t *id = munit_malloc(sizeof(cuid_t));
+    cuid_create_inplace(id, "fing");
+    cuid_init_inplace(id, 123456789);
+
+    char cuid1[CUID_SIZE] = {0};
+    cuid_read_ptr(id, cuid1);
+    munit_logf(MUNIT_LOG_INFO, "cuid1: %s", cuid1);
+    char expected_cuid1[CUID_SIZE] = {0};
+    cuid_tests_fixture(expected_cuid1, 123456789, "0000fing00000000");
+    for (size_t i = 0; i < CUID_RANDOM1_OFFSET; ++i) {
+      munit_assert_char(cuid1[i], ==, expected_cuid1[i]);
+    }
+
+    // The value API must produce the same string from the same state
+    cuid_t *copy = munit_malloc(sizeof(cuid_t));
+    *copy = cuid_init(*id, 123456789);
+    char cuid1_value[CUID_SIZE] = {0};
+    cuid_read(*copy, cuid1_value);
+    munit_assert_string_equal(cuid1, cuid1_value);
+
+    // And advance in the same way
+    cuid_next_inplace(id, 223456789);
+    *copy = cuid_next(*copy, 223456789);
+    char cuid2[CUID_SIZE] = {0};
+    char cuid2_value[CUID_SIZE] = {0};
+    cuid_read_ptr(id, cuid2);
+    cuid_read(*copy, cuid2_value);
+    munit_logf(MUNIT_LOG_INFO, "cuid2: %s", cuid2);
+    munit_assert_string_equal(cuid2, cuid2_value);
+    munit_assert_string_not_equal(cuid1, cuid2);
+
+    free(copy);
+    free(id);
+    return MUNIT_OK;
+}
+
+/*
+** Test that the random fill functions make the numbers of the single step
+** functions, and that the batch cuids made from them still match the
+** single cuids for more than one fill piece.
+*/
+static MunitResult
+test_fill_random(const MunitParameter params[], void* data) {
+    uint32_t filled[37] = {0};
+    cuid_pcg32_t pcg = cuid_pcg32_create();
+    cuid_pcg32_t pcg_stepped = pcg;
+    cuid_pcg32_fill_ptr(&pcg, filled, 37);
+    for (size_t i = 0; i < 37; ++i) {
+      cuid_pcg32_next_ptr(&pcg_stepped);
+      munit_assert_uint32(filled[i], ==, cuid_pcg32_read_ptr(&pcg_stepped));
+    }
+    munit_assert_uint64(pcg.pcg_state, ==, pcg_stepped.pcg_state);
+#ifndef CUID_RANDOM_PCG32
+    mwc_random_t *mwc = munit_malloc(sizeof(mwc_random_t));
+    mwc_random_t *mwc_stepped = munit_malloc(sizeof(mwc_random_t));
+    mwc_create_ptr(mwc);
+    *mwc_stepped = *mwc;
+    // Wraps around the lag table
+    for (size_t round = 0; round < 120; ++round) {
+      mwc_fill_ptr(mwc, filled, 37);
+      for (size_t i = 0; i < 37; ++i) {
+        mwc_next_random_ptr(mwc_stepped);
+        munit_assert_uint32(filled[i], ==, mwc_read_random_ptr(mwc_stepped));
+      }
+    }
+    munit_assert_uint(mwc->mwc_current_cycle, ==,
+                      mwc_stepped->mwc_current_cycle);
+    munit_assert_uint32(mwc->mwc_carry, ==, mwc_stepped->mwc_carry);
+    free(mwc_stepped);
+    free(mwc);
+#endif
+
+    cuid_t *id = munit_malloc(sizeof(cuid_t));
+    cuid_create_inplace(id, "fing");
+    cuid_init_inplace(id, 1000);
+    static char batch[100][CUID_SIZE];
+    cuid_generate_n(id, 1000, 100, batch);
+    cuid_init_inplace(id, 1000);
+    for (size_t i = 0; i < 100; ++i) {
+      char single[CUID_SIZE] = {0};
+      cuid_next_inplace(id, 1000);
+      cuid_read_ptr(id, single);
+      munit_assert_string_equal(single, batch[i]);
+    }
+    free(id);
+    return MUNIT_OK;
+}
+
+/*
+** Test that the batch functions produce the same cuids as `cuid_next`.
+*/
+static MunitResult
+test_generate_n(const MunitParameter params[], void* data) {
+    cuid_t *id = munit_malloc(sizeof(cuid_t));
+    cuid_create_inplace(id, "fing");
+    cuid_init_inplace(id, 123456789);
+
+    char batch[8][CUID_SIZE] = {{0}};
+    cuid_generate_n(id, 223456789, 8, batch);
+    char last[CUID_SIZE] = {0};
+    cuid_read_ptr(id, last);
+    munit_assert_string_equal(last, batch[7]);
+
+    // Replay the same sequence with the single cuid functions
+    cuid_init_inplace(id, 123456789);
+    for (size_t i = 0; i < 8; ++i) {
+      char single[CUID_SIZE] = {0};
+      cuid_next_inplace(id, 223456789);
+      cuid_read_ptr(id, single);
+      munit_logf(MUNIT_LOG_INFO, "cuid %zu: %s", i, batch[i]);
+      munit_assert_string_equal(single, batch[i]);
+    }
+
+    // Packed cuids are placed one after the other without terminators
+    cuid_init_inplace(id, 123456789);
+    char packed[2 * (CUID_SIZE - 1) + 1] = {0};
+    cuid_generate_stride(id, 223456789, 2, CUID_SIZE - 1, packed);
+    munit_assert_size(strlen(packed), ==, 2 * (CUID_SIZE - 1));
+    munit_assert_memory_equal(CUID_SIZE - 1, packed, batch[0]);
+    munit_assert_memory_equal(CUID_SIZE - 1, &packed[CUID_SIZE - 1], batch[1]);
+
+    // The simple API batch function
+    char simple[4][CUID_SIZE] = {{0}};
+    munit_assert_size(cuid_n(simple, 4), ==, 4);
+    for (size_t i = 0; i < 4; ++i) {
+      munit_assert_size(strlen(simple[i]), ==, CUID_SIZE - 1);
+      munit_assert_char(simple[i][0], ==, 'c');
+    }
+    munit_assert_string_not_equal(simple[0], simple[1]);
+
+    free(id);
+    return MUNIT_OK;
+}
+
+static MunitResult
+test_lazy(const MunitParameter params[], void* data) {
+    cuid_t *eager = munit_malloc(sizeof(cuid_t));
+    cuid_t *lazy = munit_malloc(sizeof(cuid_t));
+    char fingerprint[CUID_FINGERPRINT_SIZE] = "abcd";
+    cuid_create_inplace(eager, fingerprint);
+    cuid_init_inplace(eager, 123456789);
+    memcpy(lazy, eager, sizeof(cuid_t));
+
+    char expected[CUID_SIZE] = {0};
+    char result[CUID_SIZE] = {0};
+    cuid_bin_t expected_bin = {{0}};
+    cuid_bin_t bin = {{0}};
+    for (size_t i = 0; i < 100; ++i) {
+      unsigned long const timestamp = 123456789 + i / 10;
+      cuid_next_inplace(eager, timestamp);
+      cuid_read_ptr(eager, expected);
+      // Only the numbers are advanced, the string is formatted on demand
+      cuid_advance_inplace(lazy, timestamp);
+      munit_assert_size(cuid_format(lazy, result), ==, CUID_SIZE - 1);
+      munit_assert_string_equal(result, expected);
+      // And the binary form is packed straight from the numbers
+      munit_assert_int(cuid_bin_encode(expected, &expected_bin), ==, 1);
+      munit_assert_int(cuid_bin_from_state(lazy, &bin), ==, 1);
+      munit_assert_memory_equal(CUID_BIN_SIZE, bin.bytes, expected_bin.bytes);
+    }
+    free(lazy);
+    free(eager);
+    return MUNIT_OK;
+}
+
+static MunitResult
+test_next_checked(const MunitParameter params[], void* data) {
+    cuid_t *id = munit_malloc(sizeof(cuid_t));
+    char fingerprint[CUID_FINGERPRINT_SIZE] = "abcd";
+    cuid_create_inplace(id, fingerprint);
+    cuid_init_inplace(id, 1000);
+    munit_assert_uint32(id->cuid_tick_count, ==, 1);
+    munit_assert_int(cuid_next_checked(id, 1000), ==, 1);
+    munit_assert_uint32(id->cuid_tick_count, ==, 2);
+
+#ifdef CUID_ORDERED
+    // A full timestamp moves on to the next millisecond instead of failing
+    id->cuid_tick_count = CUID_COUNTER_MAX - 1;
+    char before[CUID_SIZE] = {0};
+    char after[CUID_SIZE] = {0};
+    cuid_read_ptr(id, before);
+    munit_assert_int(cuid_next_checked(id, 1000), ==, 1);
+    cuid_read_ptr(id, after);
+    munit_assert_int(strcmp(before, after), <, 0);
+    munit_assert_ulong(id->cuid_timestamp_value, ==, 1001);
+    munit_assert_uint32(id->cuid_tick_count, ==, 1);
+#else
+    // The last counter value of the timestamp can be used, but not the next
+    id->cuid_tick_count = CUID_COUNTER_MAX - 1;
+    munit_assert_int(cuid_next_checked(id, 1000), ==, 1);
+    char before[CUID_SIZE] = {0};
+    char after[CUID_SIZE] = {0};
+    cuid_read_ptr(id, before);
+    munit_assert_int(cuid_next_checked(id, 1000), ==, 0);
+    cuid_read_ptr(id, after);
+    munit_assert_string_equal(before, after);
+    // A new timestamp starts counting again
+    munit_assert_int(cuid_next_checked(id, 1001), ==, 1);
+    munit_assert_uint32(id->cuid_tick_count, ==, 1);
+
+    // The cuids made by the other functions are counted too
+    char batch[3][CUID_SIZE] = {{0}};
+    cuid_next_inplace(id, 1001);
+    cuid_generate_n(id, 1001, 3, batch);
+    cuid_skip_inplace(id, 5);
+    munit_assert_uint32(id->cuid_tick_count, ==, 10);
+    cuid_skip_inplace(id, CUID_COUNTER_MAX - 11);
+    munit_assert_int(cuid_next_checked(id, 1001), ==, 1);
+    munit_assert_int(cuid_next_checked(id, 1001), ==, 0);
+    cuid_next_inplace(id, 1001);
+    munit_assert_int(cuid_next_checked(id, 1001), ==, 0);
+    cuid_generate_n(id, 1002, 3, batch);
+    munit_assert_uint32(id->cuid_tick_count, ==, 3);
+#endif /* CUID_ORDERED */
+
+    free(id);
+    return MUNIT_OK;
+}
+
+static MunitResult
+test_parse(const MunitParameter params[], void* data) {
+    cuid_parts_t parts = {0};
+    char fixture[CUID_SIZE] = {0};
+    cuid_tests_fixture(fixture, 10, "000z010000zzzzzz");
+    munit_assert_int(cuid_parse(fixture, &parts), ==, 1);
+    munit_assert_uint64(parts.timestamp, ==, 10);
+    munit_assert_uint32(parts.counter, ==, 35);
+    munit_assert_uint32(parts.fingerprint, ==, 1296);
+    munit_assert_uint32(parts.random1, ==, 36 * 36 - 1);
+    munit_assert_uint32(parts.random2, ==, 36 * 36 * 36 * 36 - 1);
+
+    // The blocks of a generated cuid decode back to the same strings
+    char result[CUID_SIZE] = {0};
+    cuid(result);
+    munit_assert_int(cuid_parse(result, &parts), ==, 1);
+    char block[5] = {0};
+    cuid_base36_block(parts.counter, block);
+    munit_assert_memory_equal(4, block, &result[CUID_COUNTER_OFFSET]);
+    cuid_base36_block(parts.random2, block);
+    munit_assert_memory_equal(4, block, &result[CUID_RANDOM2_OFFSET]);
+
+    // Every single char change to an invalid char is rejected, by both the
+    // SIMD and the scalar versions
+    for (size_t i = 0; i < CUID_SIZE; ++i) {
+      static char const invalid[] = {
+        'A', 'Z', '/', ':', '`', '{', ' ', '\xff'
+      };
+      for (size_t j = 0; j < sizeof invalid; ++j) {
+        char mutated[CUID_SIZE] = {0};
+        memcpy(mutated, result, CUID_SIZE);
+        mutated[i] = invalid[j];
+        munit_assert_int(cuid_validate(mutated), ==, 0);
+        munit_assert_int(cuid_validate_scalar(mutated), ==, 0);
+      }
+    }
+    // A short string is rejected by its '\0'
+    char short_cuid[CUID_SIZE] = {0};
+    cuid_tests_fixture(short_cuid, 10, "000z00100zz0zzz0");
+    short_cuid[CUID_SIZE - 2] = '\0';
+    munit_assert_int(cuid_validate(short_cuid), ==, 0);
+
+    char cuids[3][CUID_SIZE] = {{0}};
+    cuid_n(cuids, 3);
+    cuids[1][CUID_COUNTER_OFFSET] = 'X';
+    uint8_t valid[3] = {0};
+    munit_assert_size(cuid_validate_n(cuids, 3, valid), ==, 2);
+    munit_assert_uint8(valid[0], ==, 1);
+    munit_assert_uint8(valid[1], ==, 0);
+    munit_assert_uint8(valid[2], ==, 1);
+    munit_assert_size(cuid_validate_n(cuids, 3, NULL), ==, 2);
+    return MUNIT_OK;
+}
+
+static MunitResult
+test_bin(const MunitParameter params[], void* data) {
+    // The binary form round-trips to the same string
+    char result[CUID_SIZE] = {0};
+    char decoded[CUID_SIZE] = {0};
+    cuid_bin_t bin = {{0}};
+    munit_assert_size(sizeof(cuid_bin_t), ==, CUID_BIN_SIZE);
+    for (size_t i = 0; i < 1000; ++i) {
+      cuid(result);
+      munit_assert_int(cuid_bin_encode(result, &bin), ==, 1);
+      munit_assert_size(cuid_bin_decode(&bin, decoded), ==, CUID_SIZE - 1);
+      munit_assert_string_equal(decoded, result);
+    }
+    // The largest cuid of the layout
+    char largest[CUID_SIZE] = {0};
+    memset(largest, 'z', CUID_SIZE - 1);
+    largest[0] = 'c';
+    munit_assert_int(cuid_bin_encode(largest, &bin), ==, 1);
+    cuid_bin_decode(&bin, decoded);
+    munit_assert_string_equal(decoded, largest);
+
+    // Invalid strings are rejected
+    size_t const invalid_at[] = {
+      0, CUID_RANDOM2_OFFSET, CUID_FINGERPRINT_OFFSET
+    };
+    char const invalid[] = { 'x', 'Z', ' ' };
+    for (size_t i = 0; i < sizeof invalid; ++i) {
+      char mutated[CUID_SIZE] = {0};
+      memcpy(mutated, largest, CUID_SIZE);
+      mutated[invalid_at[i]] = invalid[i];
+      munit_assert_int(cuid_bin_encode(mutated, &bin), ==, 0);
+    }
+
+    // The binary form sorts in the same order as the strings
+    char a[CUID_SIZE] = {0};
+    char b[CUID_SIZE] = {0};
+    cuid_bin_t bin_a = {{0}};
+    cuid_bin_t bin_b = {{0}};
+    for (size_t i = 0; i < 10000; ++i) {
+      a[0] = b[0] = 'c';
+      for (size_t j = 1; j < CUID_SIZE - 1; ++j) {
+        a[j] = cuid_base36_digits[munit_rand_int_range(0, 35)];
+        // Share some prefix to compare the later blocks as well
+        b[j] = j < i % CUID_SIZE
+          ? a[j] : cuid_base36_digits[munit_rand_int_range(0, 35)];
+      }
+      cuid_bin_encode(a, &bin_a);
+      cuid_bin_encode(b, &bin_b);
+      int const str_order = strcmp(a, b);
+      int const bin_order = memcmp(bin_a.bytes, bin_b.bytes, CUID_BIN_SIZE);
+      munit_assert_int(str_order < 0, ==, bin_order < 0);
+      munit_assert_int(str_order == 0, ==, bin_order == 0);
+    }
+    return MUNIT_OK;
+}
+
+/*
+** Test that a reseeded copy of a state makes other cuids than the original,
+** and that a forked child does so by itself with CUID_FORK_SAFE.
+*/
+static MunitResult
+test_reseed(const MunitParameter params[], void* data) {
+    cuid_t *id = malloc(sizeof(cuid_t));
+    cuid_t *copy = malloc(sizeof(cuid_t));
+    cuid_t *other_copy = malloc(sizeof(cuid_t));
+    cuid_create_inplace(id, "abcd");
+    cuid_init_inplace(id, 123456);
+    memcpy(copy, id, sizeof(cuid_t));
+    memcpy(other_copy, id, sizeof(cuid_t));
+    cuid_reseed_inplace(copy, 42);
+    cuid_reseed_inplace(other_copy, 42);
+
+    char a[CUID_SIZE] = {0};
+    char b[CUID_SIZE] = {0};
+    char c[CUID_SIZE] = {0};
+    for (size_t i = 0; i < 100; ++i) {
+      cuid_next_inplace(id, 123456);
+      cuid_next_inplace(copy, 123456);
+      cuid_next_inplace(other_copy, 123456);
+      cuid_read_ptr(id, a);
+      cuid_read_ptr(copy, b);
+      cuid_read_ptr(other_copy, c);
+      // The same fingerprint and timestamp, other random blocks
+      munit_assert_memory_equal(CUID_COUNTER_OFFSET, a, b);
+      munit_assert_memory_equal(4, &a[CUID_FINGERPRINT_OFFSET],
+                                &b[CUID_FINGERPRINT_OFFSET]);
+      munit_assert_memory_not_equal(8, &a[CUID_RANDOM1_OFFSET],
+                                    &b[CUID_RANDOM1_OFFSET]);
+      // Reseeding is deterministic for the same entropy and process
+      munit_assert_string_equal(b, c);
+    }
+
+#ifdef CUID_FORK_SAFE
+    int fds[2] = {0, 0};
+    munit_assert_int(pipe(fds), ==, 0);
+    pid_t const child = fork();
+    munit_assert_int(child, >=, 0);
+    cuid_next_inplace(id, 123456);
+    cuid_read_ptr(id, a);
+    if (child == 0) {
+      ssize_t const written = write(fds[1], a, CUID_SIZE);
+      _exit(written == CUID_SIZE ? 0 : 1);
+    }
+    munit_assert_int((int)read(fds[0], b, CUID_SIZE), ==, CUID_SIZE);
+    waitpid(child, 0x0, 0);
+    close(fds[0]);
+    close(fds[1]);
+    munit_assert_memory_not_equal(8, &a[CUID_RANDOM1_OFFSET],
+                                  &b[CUID_RANDOM1_OFFSET]);
+#endif /* CUID_FORK_SAFE */
+    free(other_copy);
+    free(copy);
+    free(id);
+    return MUNIT_OK;
+}
+
+/*
+** Test that a state restored from its snapshot makes the same cuids as the
+** state it was taken from.
+*/
+static MunitResult
+test_snapshot(const MunitParameter params[], void* data) {
+    cuid_t *id = malloc(sizeof(cuid_t));
+    cuid_t *restored = malloc(sizeof(cuid_t));
+    cuid_create_inplace(id, "abcd");
+    cuid_init_inplace(id, 123456);
+    for (size_t i = 0; i < 1000; ++i) {
+      cuid_next_inplace(id, 123456 + i / 100);
+    }
+    uint8_t *snapshot = munit_malloc(CUID_SNAPSHOT_SIZE);
+    munit_assert_size(cuid_snapshot(id, snapshot), ==, CUID_SNAPSHOT_SIZE);
+#if defined(CUID_RANDOM_PCG32) || defined(CUID_MWC_SEEDED)
+    munit_assert_size(CUID_SNAPSHOT_SIZE, <, 128);
+#endif
+    memset(restored, 0xff, sizeof(cuid_t));
+    munit_assert_int(cuid_restore(restored, snapshot), ==, 1);
+#ifdef CUID_STATS
+    // The counters of the restored state start again
+    cuid_stats_t stats = {0, 0, 0, 0, 0};
+    cuid_stats_read(restored, &stats);
+    munit_assert_uint64(stats.cuid_generated, ==, 0);
+    munit_assert_uint64(stats.cuid_reseeds, ==, 0);
+#endif /* CUID_STATS */
+
+    char a[CUID_SIZE] = {0};
+    char b[CUID_SIZE] = {0};
+    cuid_read_ptr(id, a);
+    cuid_read_ptr(restored, b);
+    munit_assert_string_equal(a, b);
+    for (size_t i = 0; i < 1000; ++i) {
+      cuid_next_inplace(id, 123466 + i / 100);
+      cuid_next_inplace(restored, 123466 + i / 100);
+      cuid_read_ptr(id, a);
+      cuid_read_ptr(restored, b);
+      munit_assert_string_equal(a, b);
+    }
+    // Both restart the same sequence
+    cuid_init_inplace(id, 1);
+    cuid_init_inplace(restored, 1);
+    cuid_read_ptr(id, a);
+    cuid_read_ptr(restored, b);
+    munit_assert_string_equal(a, b);
+
+    snapshot[0] = CUID_SNAPSHOT_VERSION + 1;
+    munit_assert_int(cuid_restore(restored, snapshot), ==, 0);
+    free(snapshot);
+    free(restored);
+    free(id);
+    return MUNIT_OK;
+}
+
+/*
+** Test that skipping ahead gives the same cuids as stepping, and that the
+** substreams of a split make different cuids.
+*/
+static MunitResult
+test_skip_split(const MunitParameter params[], void* data) {
+    cuid_t *stepped = malloc(sizeof(cuid_t));
+    cuid_t *skipped = malloc(sizeof(cuid_t));
+    cuid_create_inplace(stepped, "abcd");
+    cuid_init_inplace(stepped, 123456);
+    *skipped = *stepped;
+    char a[CUID_SIZE] = {0};
+    char b[CUID_SIZE] = {0};
+    for (size_t i = 0; i < 5000; ++i) {
+      cuid_next_inplace(stepped, 123456);
+    }
+    cuid_skip_inplace(skipped, 5000);
+    cuid_read_ptr(stepped, a);
+    cuid_read_ptr(skipped, b);
+    munit_assert_string_equal(a, b);
+    cuid_next_inplace(stepped, 123456);
+    cuid_next_inplace(skipped, 123456);
+    cuid_read_ptr(stepped, a);
+    cuid_read_ptr(skipped, b);
+    munit_assert_string_equal(a, b);
+
+    // Also when the counters of the timestamp are used up on the way, which
+    // moves on to the next milliseconds with CUID_ORDERED
+    uint32_t const counts[] = { CUID_COUNTER_MAX - 3, CUID_COUNTER_MAX };
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+      uint64_t const n = c == 0 ? 10 : 2 * (uint64_t)CUID_COUNTER_MAX + 5;
+      stepped->cuid_tick_count = counts[c];
+      *skipped = *stepped;
+      for (uint64_t i = 0; i < n; ++i) {
+        cuid_next_inplace(stepped, stepped->cuid_timestamp_value);
+      }
+      cuid_skip_inplace(skipped, n);
+      cuid_read_ptr(stepped, a);
+      cuid_read_ptr(skipped, b);
+      munit_assert_string_equal(a, b);
+      munit_assert_ulong(skipped->cuid_timestamp_value, ==,
+                         stepped->cuid_timestamp_value);
+      munit_assert_uint32(skipped->cuid_tick_count, ==,
+                          stepped->cuid_tick_count);
+#ifdef CUID_STATS
+      cuid_stats_t stepped_stats = {0, 0, 0, 0, 0};
+      cuid_stats_t skipped_stats = {0, 0, 0, 0, 0};
+      cuid_stats_read(stepped, &stepped_stats);
+      cuid_stats_read(skipped, &skipped_stats);
+      munit_assert_memory_equal(sizeof(cuid_stats_t), &skipped_stats,
+                                &stepped_stats);
+#endif /* CUID_STATS */
+    }
+
+    // Skipping the counter is the same as stepping it one at a time, also
+    // from a counter restored near UINT32_MAX and across the end of its block
+    uint64_t const starts[] = { UINT32_MAX - 3, CUID_COUNTER_MAX - 3 };
+    for (size_t s = 0; s < sizeof(starts) / sizeof(starts[0]); ++s) {
+      CUID_COUNTER_T stepped_counter = CUID_CREATE_COUNTER();
+      CUID_RESTORE_COUNTER_PTR(&stepped_counter, starts[s]);
+      CUID_COUNTER_T skipped_counter = stepped_counter;
+      for (size_t i = 0; i < 10; ++i) {
+        CUID_INCREASE_COUNTER_PTR(&stepped_counter);
+      }
+      CUID_SKIP_COUNTER_PTR(&skipped_counter, 10);
+      munit_assert_uint(CUID_READ_COUNTER_PTR(&skipped_counter), ==,
+                        CUID_READ_COUNTER_PTR(&stepped_counter));
+      munit_assert_uint(CUID_READ_COUNTER_PTR(&skipped_counter), <,
+                        CUID_COUNTER_MAX);
+    }
+
+    cuid_t *substreams = malloc(4 * sizeof(cuid_t));
+    cuid_split(stepped, 4, substreams);
+    char ids[4][CUID_SIZE] = {{0}};
+    for (size_t i = 0; i < 4; ++i) {
+      cuid_next_inplace(&substreams[i], 123456);
+      cuid_read_ptr(&substreams[i], ids[i]);
+    }
+    // The first substream continues the original
+    cuid_next_inplace(stepped, 123456);
+    cuid_read_ptr(stepped, a);
+    munit_assert_string_equal(ids[0], a);
+    for (size_t i = 1; i < 4; ++i) {
+      uint64_t counter = 0;
+      uint64_t previous = 0;
+      cuid_base36_decode(&ids[i][CUID_COUNTER_OFFSET], 4, &counter);
+      cuid_base36_decode(&ids[i - 1][CUID_COUNTER_OFFSET], 4, &previous);
+      munit_assert_uint64((counter + CUID_COUNTER_MAX - previous)
+                          % CUID_COUNTER_MAX, ==,
+                          CUID_COUNTER_MAX / 4);
+      munit_assert_memory_not_equal(8, &ids[i][CUID_RANDOM1_OFFSET],
+                                    &ids[i - 1][CUID_RANDOM1_OFFSET]);
+    }
+    // The substreams of another state have other random sequences
+    cuid_t *other = malloc(4 * sizeof(cuid_t));
+    cuid_next_inplace(stepped, 123456);
+    cuid_split(stepped, 4, other);
+    for (size_t i = 1; i < 4; ++i) {
+      cuid_next_inplace(&other[i], 123456);
+      cuid_read_ptr(&other[i], a);
+      munit_assert_memory_not_equal(8, &a[CUID_RANDOM1_OFFSET],
+                                    &ids[i][CUID_RANDOM1_OFFSET]);
+    }
+    free(other);
+    free(substreams);
+    free(skipped);
+    free(stepped);
+    return MUNIT_OK;
+}
+
+/*
+** Test that the word compares order cuids as strcmp, for the string and the
+** binary forms, and that the hashes follow equality.
+*/
+static MunitResult
+test_hash_compare(const MunitParameter params[], void* data) {
+    char a[CUID_SIZE] = {0};
+    char b[CUID_SIZE] = {0};
+    cuid_bin_t bin_a = {{0}};
+    cuid_bin_t bin_b = {{0}};
+    for (size_t i = 0; i < 10000; ++i) {
+      a[0] = b[0] = 'c';
+      for (size_t j = 1; j < CUID_SIZE - 1; ++j) {
+        a[j] = cuid_base36_digits[munit_rand_int_range(0, 35)];
+        // Share some prefix, up to the whole string
+        b[j] = j < i % (CUID_SIZE + 1)
+          ? a[j] : cuid_base36_digits[munit_rand_int_range(0, 35)];
+      }
+      cuid_bin_encode(a, &bin_a);
+      cuid_bin_encode(b, &bin_b);
+      int const order = strcmp(a, b);
+      int const expected = order < 0 ? -1 : order > 0;
+      munit_assert_int(cuid_compare(a, b), ==, expected);
+      munit_assert_int(cuid_compare(b, a), ==, -expected);
+      munit_assert_int(cuid_bin_compare(&bin_a, &bin_b), ==, expected);
+      munit_assert_int(cuid_equal(a, b), ==, order == 0);
+      munit_assert_int(cuid_bin_equal(&bin_a, &bin_b), ==, order == 0);
+      if (order == 0) {
+        munit_assert_uint64(cuid_hash(a), ==, cuid_hash(b));
+        munit_assert_uint64(cuid_bin_hash(&bin_a), ==, cuid_bin_hash(&bin_b));
+      } else {
+        munit_assert_uint64(cuid_hash(a), !=, cuid_hash(b));
+      }
+    }
+    return MUNIT_OK;
+}
+
+#ifdef CUID_WRITER
+/*
+** A sink for `test_writer` that copies the chunks into memory, and fails
+** once `fail_after` chunks were written.
+*/
+typedef struct cuid_tests_sink_t {
+    char data[512 * CUID_SIZE];
+    size_t length;
+    size_t calls;
+    size_t fail_after;
+} cuid_tests_sink_t;
+
+static int
+cuid_tests_sink(void *context, struct iovec const *chunks, int const count) {
+    cuid_tests_sink_t *sink = (cuid_tests_sink_t *)context;
+    if (sink->calls == sink->fail_after) {
+        return 0;
+    }
+    sink->calls++;
+    for (int i = 0; i < count; ++i) {
+        memcpy(&sink->data[sink->length], chunks[i].iov_base,
+               chunks[i].iov_len);
+        sink->length += chunks[i].iov_len;
+    }
+    return 1;
+}
+
+/*
+** Checks that the output of a writer has `n` delimited cuids in a row.
+*/
+static void
+cuid_tests_assert_written(char const *data, size_t const n,
+                          char const delimiter) {
+    cuid_parts_t previous = {0};
+    for (size_t i = 0; i < n; ++i) {
+        char result[CUID_SIZE] = {0};
+        cuid_parts_t parts = {0};
+        memcpy(result, &data[i * CUID_SIZE], CUID_SIZE - 1);
+        munit_assert_char(data[i * CUID_SIZE + CUID_SIZE - 1], ==, delimiter);
+        munit_assert_int(cuid_parse(result, &parts), ==, 1);
+        if (i > 0) {
+            munit_assert_uint32((parts.counter + CUID_COUNTER_MAX
+                                 - previous.counter) % CUID_COUNTER_MAX,
+                                ==, 1);
+        }
+        previous = parts;
+    }
+}
+
+/*
+** Test that the writer streams delimited cuids to its sink, each time half
+** of its buffer is full, to a file descriptor and from its background
+** flusher.
+*/
+static MunitResult
+test_writer(const MunitParameter params[], void* data) {
+    static cuid_writer_t writer;
+    static cuid_tests_sink_t sink;
+    char buffer[10 * CUID_SIZE + 10];
+    munit_assert_int(cuid_writer_init(&writer, buffer, CUID_SIZE, '\n',
+                                      cuid_tests_sink, &sink, "abcd"), ==, 0);
+
+    // Flushed each 5 cuids, the half of the buffer
+    sink.fail_after = SIZE_MAX;
+    munit_assert_int(cuid_writer_init(&writer, buffer, sizeof(buffer), '\n',
+                                      cuid_tests_sink, &sink, "abcd"), ==, 1);
+    munit_assert_size(cuid_writer_write_n(&writer, 1000, 12), ==, 12);
+    munit_assert_size(sink.calls, ==, 2);
+    munit_assert_size(sink.length, ==, 10 * CUID_SIZE);
+    munit_assert_int(cuid_writer_flush(&writer), ==, 1);
+    munit_assert_size(sink.length, ==, 12 * CUID_SIZE);
+    cuid_tests_assert_written(sink.data, 12, '\n');
+
+    // Nothing is written once the sink fails
+    sink.fail_after = sink.calls;
+    munit_assert_size(cuid_writer_write_n(&writer, 1000, 12), ==, 5);
+    munit_assert_int(cuid_writer_flush(&writer), ==, 0);
+    munit_assert_size(sink.length, ==, 12 * CUID_SIZE);
+    cuid_writer_destroy(&writer);
+
+    // Written with `writev` to a pipe
+    int fds[2];
+    munit_assert_int(pipe(fds), ==, 0);
+    munit_assert_int(cuid_writer_init(&writer, buffer, sizeof(buffer), ',',
+                                      cuid_fd_sink, &fds[1], "abcd"), ==, 1);
+    munit_assert_size(cuid_writer_write_n(&writer, 1000, 32), ==, 32);
+    munit_assert_int(cuid_writer_flush(&writer), ==, 1);
+    char piped[32 * CUID_SIZE];
+    size_t piped_length = 0;
+    while (piped_length < sizeof(piped)) {
+        ssize_t const bytes = read(fds[0], &piped[piped_length],
+                                   sizeof(piped) - piped_length);
+        munit_assert_true(bytes > 0);
+        piped_length += (size_t)bytes;
+    }
+    close(fds[0]);
+    close(fds[1]);
+    cuid_tests_assert_written(piped, 32, ',');
+    cuid_writer_destroy(&writer);
+#ifdef CUID_THREADS
+
+    // Double buffered, by the background flusher
+    sink.length = 0;
+    sink.calls = 0;
+    sink.fail_after = SIZE_MAX;
+    munit_assert_int(cuid_writer_init(&writer, buffer, sizeof(buffer), '\n',
+                                      cuid_tests_sink, &sink, "abcd"), ==, 1);
+    munit_assert_int(cuid_writer_start(&writer), ==, 1);
+    for (size_t i = 0; i < 64; ++i) {
+        munit_assert_size(cuid_writer_write_n(&writer, 1000, 7), ==, 7);
+    }
+    munit_assert_int(cuid_writer_stop(&writer), ==, 1);
+    cuid_writer_destroy(&writer);
+    munit_assert_size(sink.length, ==, 64 * 7 * CUID_SIZE);
+    cuid_tests_assert_written(sink.data, 64 * 7, '\n');
+#endif
+    return MUNIT_OK;
+}
+#endif /* CUID_WRITER */
+
+/*
+** Test that the stats count the events of a `cuid_t` and of `cuid()`, and
+** that they are all 0 when CUID_STATS is not defined.
+*/
+static MunitResult
+test_stats(const MunitParameter params[], void* data) {
+    cuid_t *id = munit_malloc(sizeof(cuid_t));
+    cuid_create_inplace(id, "fing");
+    cuid_init_inplace(id, 1000);
+    for (unsigned long i = 0; i < 10; ++i) {
+      cuid_next_inplace(id, 1000 + i / 5);
+    }
+    static char batch[100][CUID_SIZE];
+    cuid_generate_n(id, 1002, 100, batch);
+    cuid_reseed_inplace(id, 42);
+    cuid_next_inplace(id, 1002);
+    // Up to the last counter before the wrap
+    char last[CUID_SIZE] = {0};
+    cuid_parts_t parts = {0};
+    cuid_read_ptr(id, last);
+    munit_assert_int(cuid_parse(last, &parts), ==, 1);
+    // The skipped cuids are counted as generated
+    uint64_t const skipped = CUID_COUNTER_MAX - 1 - parts.counter;
+    cuid_skip_inplace(id, skipped);
+    cuid_next_inplace(id, 1002);
+
+    cuid_stats_t stats = {1, 1, 1, 1, 1};
+    cuid_stats_read(id, &stats);
+    cuid_stats_t total = {0, 0, 0, 0, 0};
+    cuid_stats_add(&total, &stats);
+    cuid_stats_add(&total, &stats);
+    cuid_stats_t before = {0, 0, 0, 0, 0};
+    cuid_stats_t after = {0, 0, 0, 0, 0};
+    char result[CUID_SIZE] = {0};
+    char results[5][CUID_SIZE] = {{0}};
+    cuid_thread_stats(&before);
+    cuid(result);
+    munit_assert_size(cuid_n(results, 5), ==, 5);
+    cuid_thread_stats(&after);
+#ifdef CUID_STATS
+    munit_assert_uint64(stats.cuid_generated, ==, 112 + skipped);
+    munit_assert_uint64(stats.cuid_counter_wraps, ==, 1);
+    munit_assert_uint64(stats.cuid_timestamp_changes, ==, 2);
+    // Each chunk of cuids is filled by two blocks of numbers
+    uint64_t const chunks = (100 + CUID_BATCH_CHUNK - 1) / CUID_BATCH_CHUNK;
+    munit_assert_uint64(stats.cuid_random_refills, ==, 2 * chunks);
+    munit_assert_uint64(stats.cuid_reseeds, ==, 1);
+    munit_assert_uint64(total.cuid_generated, ==, 2 * (112 + skipped));
+    munit_assert_uint64(total.cuid_random_refills, ==, 4 * chunks);
+    munit_assert_uint64(after.cuid_generated - before.cuid_generated, ==, 6);
+#else
+    munit_assert_uint64(stats.cuid_generated, ==, 0);
+    munit_assert_uint64(stats.cuid_reseeds, ==, 0);
+    munit_assert_uint64(total.cuid_generated, ==, 0);
+    munit_assert_uint64(after.cuid_generated, ==, 0);
+#endif /* CUID_STATS */
+    free(id);
+    return MUNIT_OK;
+}
+
+/*
+** Test that the milliseconds timestamp follows the clock, and with
+** CUID_ORDERED that the cuids of a generator are strictly increasing, also
+** when the clock goes back or a millisecond runs out of counters.
+*/
+static MunitResult
+test_ordered(const MunitParameter params[], void* data) {
+#ifdef CLOCK_REALTIME
+    unsigned long const ms = cuid_get_timestamp_ms();
+    unsigned long const seconds = (unsigned long)time(0x0);
+    // `time()` can be served from a coarser clock
+    munit_assert_ulong(ms / 1000, <=, seconds + 1);
+    munit_assert_ulong(ms / 1000 + 1, >=, seconds);
+#endif /* CLOCK_REALTIME */
+#ifdef CUID_ORDERED
+    cuid_t *id = munit_malloc(sizeof(cuid_t));
+    cuid_create_inplace(id, "fing");
+    cuid_init_inplace(id, 5000);
+    char previous[CUID_SIZE] = {0};
+    char current[CUID_SIZE] = {0};
+    cuid_read_ptr(id, previous);
+    unsigned long const timestamps[] = { 5000, 5001, 4000, 5001, 6000 };
+    for (size_t i = 0; i < 5 * 3; ++i) {
+        cuid_next_inplace(id, timestamps[i / 3]);
+        cuid_read_ptr(id, current);
+        munit_assert_int(strcmp(previous, current), <, 0);
+        memcpy(previous, current, CUID_SIZE);
+    }
+    // The counter starts again with each newer timestamp
+    cuid_parts_t parts = {0};
+    munit_assert_int(cuid_parse(current, &parts), ==, 1);
+    munit_assert_uint64(parts.timestamp, ==, 6000);
+    munit_assert_uint32(parts.counter, ==, 3);
+    // A full millisecond moves on to the next one
+    for (uint32_t i = 3; i < CUID_COUNTER_MAX - 1; ++i) {
+        cuid_advance_inplace(id, 6000);
+    }
+    cuid_next_inplace(id, 6000);
+    cuid_read_ptr(id, current);
+    munit_assert_int(strcmp(previous, current), <, 0);
+    munit_assert_int(cuid_parse(current, &parts), ==, 1);
+    munit_assert_uint64(parts.timestamp, ==, 6001);
+    munit_assert_uint32(parts.counter, ==, 1);
+    memcpy(previous, current, CUID_SIZE);
+    static char batch[100][CUID_SIZE];
+    cuid_generate_n(id, 5500, 100, batch);
+    for (size_t i = 0; i < 100; ++i) {
+        munit_assert_int(strcmp(previous, batch[i]), <, 0);
+        memcpy(previous, batch[i], CUID_SIZE);
+    }
+    free(id);
+#ifdef CUID_THREADS
+    cuid_shared_t shared;
+    cuid_shared_init(&shared, "fing");
+    cuid_shared_next(&shared, 7000, previous);
+    for (size_t i = 0; i < 4; ++i) {
+        cuid_shared_next(&shared, i < 2 ? 7000 : 6000, current);
+        munit_assert_int(strcmp(previous, current), <, 0);
+        memcpy(previous, current, CUID_SIZE);
+    }
+    cuid_shared_next(&shared, 7001, current);
+    munit_assert_int(strcmp(previous, current), <, 0);
+    munit_assert_int(cuid_parse(current, &parts), ==, 1);
+    munit_assert_uint32(parts.counter, ==, 0);
+#endif /* CUID_THREADS */
+#endif /* CUID_ORDERED */
+    return MUNIT_OK;
+}
+
+#ifdef CUID_ARENA
+/*
+** Test that the generators of an arena make valid cuids with their own
+** counter and random numbers, in caller provided and in mapped slots.
+*/
+static MunitResult
+test_arena(const MunitParameter params[], void* data) {
+    static cuid_arena_slot_t slots[64];
+    cuid_arena_t arena;
+    munit_assert_int(cuid_arena_init(&arena, slots, 0, "fing"), ==, 0);
+    munit_assert_int(cuid_arena_init(&arena, slots, 64, "fing"), ==, 1);
+#if !defined(CUID_ORDERED) && !defined(CUID_FORK_SAFE)
+    munit_assert_size(sizeof(cuid_arena_slot_t), ==, 16);
+#endif
+    char first[CUID_SIZE] = {0};
+    char second[CUID_SIZE] = {0};
+    char other[CUID_SIZE] = {0};
+    munit_assert_size(cuid_arena_next(&arena, 64, 1000, first), ==, 0);
+    munit_assert_size(cuid_arena_next(&arena, 3, 1000, first), ==,
+                      CUID_SIZE - 1);
+    munit_assert_size(cuid_arena_next(&arena, 3, 1000, second), ==,
+                      CUID_SIZE - 1);
+    munit_assert_size(cuid_arena_next(&arena, 4, 1001, other), ==,
+                      CUID_SIZE - 1);
+    cuid_parts_t parts1 = {0};
+    cuid_parts_t parts2 = {0};
+    cuid_parts_t parts3 = {0};
+    munit_assert_int(cuid_parse(first, &parts1), ==, 1);
+    munit_assert_int(cuid_parse(second, &parts2), ==, 1);
+    munit_assert_int(cuid_parse(other, &parts3), ==, 1);
+    munit_assert_uint64(parts1.timestamp, ==, 1000);
+    munit_assert_uint64(parts3.timestamp, ==, 1001);
+    munit_assert_uint32(parts2.counter, ==, parts1.counter + 1);
+    munit_assert_uint32(parts3.counter, ==, parts1.counter);
+    munit_assert_memory_equal(4, &first[CUID_FINGERPRINT_OFFSET], "fing");
+    munit_assert_memory_not_equal(8, &first[CUID_RANDOM1_OFFSET],
+                                  &other[CUID_RANDOM1_OFFSET]);
+    munit_assert_int(strcmp(first, second), <, 0);
+    cuid_arena_destroy(&arena);
+
+    // Many generators in mapped pages
+    munit_assert_int(cuid_arena_map(&arena, 1 << 14, "fing"), ==, 1);
+    for (size_t i = 0; i < 1 << 14; i += 1021) {
+        munit_assert_size(cuid_arena_next(&arena, i, 1000, first), ==,
+                          CUID_SIZE - 1);
+        munit_assert_int(cuid_validate(first), ==, 1);
+    }
+    cuid_arena_destroy(&arena);
+    munit_assert_size(cuid_arena_next(&arena, 0, 1000, first), ==, 0);
+    return MUNIT_OK;
+}
+#endif /* CUID_ARENA */
+
+#ifdef CUID_SHM
+/*
+** Test that the handles on a shared memory segment take different counter
+** blocks, also in a forked child with CUID_FORK_SAFE.
+*/
+static MunitResult
+test_shm(const MunitParameter params[], void* data) {
+    char name[64] = {0};
+    snprintf(name, sizeof name, "/cuid_tests_%ld", (long)getpid());
+    cuid_shm_t first;
+    cuid_shm_t second;
+    munit_assert_int(cuid_shm_open(&first, name, "fing"), ==, 1);
+    munit_assert_int(cuid_shm_open(&second, name, "fing"), ==, 1);
+    char a[CUID_SIZE] = {0};
+    char b[CUID_SIZE] = {0};
+    cuid_parts_t parts = {0};
+    munit_assert_size(cuid_shm_next(&first, 1000, a), ==, CUID_SIZE - 1);
+    munit_assert_size(cuid_shm_next(&second, 1000, b), ==, CUID_SIZE - 1);
+    munit_assert_int(cuid_parse(a, &parts), ==, 1);
+    munit_assert_uint32(parts.counter, ==, 0);
+    munit_assert_uint64(parts.timestamp, ==, 1000);
+    munit_assert_int(cuid_parse(b, &parts), ==, 1);
+    munit_assert_uint32(parts.counter, ==, CUID_SHM_COUNTER_BLOCK);
+    munit_assert_memory_equal(4, &b[CUID_FINGERPRINT_OFFSET], "fing");
+    // The rest of the block is used before taking another one
+    for (uint32_t i = 1; i < CUID_SHM_COUNTER_BLOCK; ++i) {
+        cuid_shm_next(&first, 1000, a);
+    }
+    munit_assert_int(cuid_parse(a, &parts), ==, 1);
+    munit_assert_uint32(parts.counter, ==, CUID_SHM_COUNTER_BLOCK - 1);
+    cuid_shm_next(&first, 1001, a);
+    munit_assert_int(cuid_parse(a, &parts), ==, 1);
+    munit_assert_uint32(parts.counter, ==, 2 * CUID_SHM_COUNTER_BLOCK);
+#ifdef CUID_FORK_SAFE
+    int fds[2] = {0, 0};
+    munit_assert_int(pipe(fds), ==, 0);
+    pid_t const child = fork();
+    munit_assert_int(child, >=, 0);
+    cuid_shm_next(&first, 1001, a);
+    if (child == 0) {
+      ssize_t const written = write(fds[1], a, CUID_SIZE);
+      _exit(written == CUID_SIZE ? 0 : 1);
+    }
+    munit_assert_int((int)read(fds[0], b, CUID_SIZE), ==, CUID_SIZE);
+    waitpid(child, 0x0, 0);
+    close(fds[0]);
+    close(fds[1]);
+    munit_assert_int(cuid_parse(b, &parts), ==, 1);
+    munit_assert_uint32(parts.counter, ==, 3 * CUID_SHM_COUNTER_BLOCK);
+#endif /* CUID_FORK_SAFE */
+    cuid_shm_close(&second);
+    cuid_shm_close(&first);
+    munit_assert_int(cuid_shm_unlink(name), ==, 1);
+    munit_assert_int(cuid_shm_unlink(name), ==, 0);
+    return MUNIT_OK;
+}
+#endif /* CUID_SHM */
+
 /*
 ** The main() function is included to be able to run the cuid tests directly in
 ** the CLI. This function is the unit tests entry-point.
@@ -430,18 +1941,47 @@ int main(int argc, char* argv[MUNIT_ARRAY_PARAM(argc + 1)]) {
         { (char*) "test_padded_base36",
           test_padded_base36,
             0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+        { (char*) "test_fixed_base36",
+          test_fixed_base36,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+        { (char*) "test_base36_blocks",
+          test_base36_blocks,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
         { (char*) "test_has_counter",
           test_has_counter,
             0, 0, MUNIT_TEST_OPTION_NONE, 0 },
         { (char*) "test_timestamp",
           test_timestamp,
             0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+        { (char*) "test_timestamp_cache",
+          test_timestamp_cache,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
         { (char*) "test_has_random",
           test_has_random,
             0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+        { (char*) "test_pcg32",
+          test_pcg32,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
         { (char*) "test_cuid",
           test_cuid,
             0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+        { (char*) "test_fingerprint_cache",
+          test_fingerprint_cache,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+#ifdef CUID_THREADS
+        { (char*) "test_cuid_threads",
+          test_cuid_threads,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+        { (char*) "test_shared",
+          test_shared,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+        { (char*) "test_pool",
+          test_pool,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+#endif
+        { (char*) "test_buffered_random",
+          test_buffered_random,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
         { (char*) "test_create",
           test_create,
             0, 0, MUNIT_TEST_OPTION_NONE, 0 },
@@ -451,6 +1991,63 @@ int main(int argc, char* argv[MUNIT_ARRAY_PARAM(argc + 1)]) {
         { (char*) "test_read",
           test_read,
             0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+        { (char*) "test_inplace",
+          test_inplace,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+        { (char*) "test_generate_n",
+          test_generate_n,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+        { (char*) "test_lazy",
+          test_lazy,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+        { (char*) "test_next_checked",
+          test_next_checked,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+        { (char*) "test_parse",
+          test_parse,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+        { (char*) "test_bin",
+          test_bin,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+        { (char*) "test_reseed",
+          test_reseed,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+        { (char*) "test_snapshot",
+          test_snapshot,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+        { (char*) "test_skip_split",
+          test_skip_split,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+#ifdef CUID_WRITER
+        { (char*) "test_writer",
+          test_writer,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+#endif
+        { (char*) "test_cpu_dispatch",
+          test_cpu_dispatch,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+        { (char*) "test_fill_random",
+          test_fill_random,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+        { (char*) "test_stats",
+          test_stats,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+        { (char*) "test_ordered",
+          test_ordered,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+#ifdef CUID_ARENA
+        { (char*) "test_arena",
+          test_arena,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+#endif
+#ifdef CUID_SHM
+        { (char*) "test_shm",
+          test_shm,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
+#endif
+        { (char*) "test_hash_compare",
+          test_hash_compare,
+            0, 0, MUNIT_TEST_OPTION_NONE, 0 },
         { NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
 
     };